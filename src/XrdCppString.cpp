@@ -1,6 +1,7 @@
 #include "XrdOucString.hh"
 #include <string>
 #include <cstring>
+#include "alloccounter.hpp"
 #include "benchmark/benchmark.h"
 
 #define STR(X) #X
@@ -13,6 +14,7 @@ static void BM_StringCreate(benchmark::State& state)
 {
   std::string _s(state.range(0), 'a');
   const char* s = _s.c_str();
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     benchmark::DoNotOptimize(std::string(s));
   }
@@ -23,6 +25,7 @@ static void BM_XrdStringCreate(benchmark::State& state)
   std::string _s(state.range(0), 'a');
   const char* s = _s.c_str();
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     benchmark::DoNotOptimize(XrdOucString(s));
   }
@@ -32,6 +35,7 @@ static void BM_XrdStringCreate(benchmark::State& state)
 static void BM_StringAppend(benchmark::State& state)
 {
   std::string s("This is a line");
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     for (size_t i=0; i<state.range(0); ++i)
       benchmark::DoNotOptimize(s += "a");
@@ -41,6 +45,7 @@ static void BM_StringAppend(benchmark::State& state)
 static void BM_XrdStringAppend(benchmark::State& state)
 {
   XrdOucString s("This is a line");
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     for (size_t i=0; i<state.range(0); ++i)
       benchmark::DoNotOptimize(s += "a");
@@ -53,4 +58,4 @@ BENCHMARK(BM_XrdStringCreate)->RangeMultiplier(2)->Range(8,1<<10);
 BENCHMARK(BM_StringAppend)->RangeMultiplier(2)->Range(8,1<<10);
 BENCHMARK(BM_XrdStringAppend)->RangeMultiplier(2)->Range(8,1<<10);
 
-BENCHMARK_MAIN();
+EOS_BENCHMARK_MAIN();
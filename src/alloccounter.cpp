@@ -0,0 +1,375 @@
+// ----------------------------------------------------------------------
+// File: alloccounter.cpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "alloccounter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if EOS_ALLOC_COUNTERS
+
+#if !defined(__GLIBC__)
+#error "the allocation hooks need glibc, configure with -DMICROBENCH_ALLOC_COUNTERS=OFF"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <malloc.h>
+#include <new>
+
+// glibc's own allocator, which the hooks below forward to
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t alignment, size_t n);
+void __libc_free(void* p);
+}
+
+namespace {
+
+// set for the duration of the memory measurement run only, so that the
+// timed runs pay a load and a branch per call
+std::atomic<bool> gArmed {false};
+
+bool armed()
+{
+  return gArmed.load(std::memory_order_relaxed);
+}
+
+// a plain thread local without constructor or destructor, so it can be
+// touched from malloc at any point of a thread's life and costs no more
+// than a few increments per call
+thread_local eos::common::AllocStats tStats;
+
+void* count_alloc(void* p)
+{
+  if (p && armed()) {
+    auto n = malloc_usable_size(p);
+    tStats.allocs++;
+    tStats.bytes += n;
+    tStats.live += n;
+    if (tStats.live > tStats.peak) {
+      tStats.peak = tStats.live;
+    }
+  }
+  return p;
+}
+
+void count_free(void* p)
+{
+  if (p && armed()) {
+    tStats.live -= malloc_usable_size(p);
+  }
+}
+
+void* new_impl(size_t n, size_t alignment)
+{
+  while (true) {
+    void* p = alignment ? memalign(alignment, n) : malloc(n ? n : 1);
+    if (p) {
+      return p;
+    }
+    if (auto handler = std::get_new_handler()) {
+      handler();
+    } else {
+      throw std::bad_alloc();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Arms the hooks for the memory measurement run of a benchmark and reports
+// the allocations of its AllocCounters scope. That run is single threaded,
+// so the stats of the calling thread cover it.
+//----------------------------------------------------------------------------
+class AllocMemoryManager : public benchmark::MemoryManager {
+public:
+  void Start() override {
+    scoped = false;
+    gArmed.store(true);
+  }
+
+  void Stop(Result& result) override {
+    gArmed.store(false);
+    if (!scoped) {
+      return;
+    }
+    result.num_allocs = end.allocs - begin.allocs;
+    result.total_allocated_bytes = end.bytes - begin.bytes;
+    result.max_bytes_used = end.peak - begin.live;
+    result.net_heap_growth = end.live - begin.live;
+  }
+
+  // the pure virtual one before google benchmark 1.8
+  void Stop(Result* result) {
+    Stop(*result);
+  }
+
+  void begin_scope() {
+    eos::common::ResetAllocPeak();
+    begin = tStats;
+  }
+
+  void end_scope() {
+    end = tStats;
+    scoped = true;
+  }
+
+private:
+  bool scoped {false};
+  eos::common::AllocStats begin;
+  eos::common::AllocStats end;
+};
+
+AllocMemoryManager gMemoryManager;
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t n)
+{
+  return count_alloc(__libc_malloc(n));
+}
+
+void* calloc(size_t n, size_t size)
+{
+  return count_alloc(__libc_calloc(n, size));
+}
+
+void* realloc(void* p, size_t n)
+{
+  if (!armed()) {
+    return __libc_realloc(p, n);
+  }
+  size_t old = p ? malloc_usable_size(p) : 0;
+  void* q = __libc_realloc(p, n);
+  // on failure p is left alone, unless it was freed by a zero size
+  if (q || n == 0) {
+    tStats.live -= old;
+  }
+  return count_alloc(q);
+}
+
+void* memalign(size_t alignment, size_t n)
+{
+  return count_alloc(__libc_memalign(alignment, n));
+}
+
+void* aligned_alloc(size_t alignment, size_t n)
+{
+  return memalign(alignment, n);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t n)
+{
+  if (alignment % sizeof(void*) || (alignment & (alignment - 1))) {
+    return EINVAL;
+  }
+  void* p = memalign(alignment, n);
+  if (!p) {
+    return ENOMEM;
+  }
+  *out = p;
+  return 0;
+}
+
+void free(void* p)
+{
+  count_free(p);
+  __libc_free(p);
+}
+
+} // extern "C"
+
+// The remaining operator new and delete overloads of libstdc++ forward to
+// these, the sized deletes are replaced too rather than relying on that
+void* operator new(size_t n)
+{
+  return new_impl(n, 0);
+}
+
+void* operator new(size_t n, std::align_val_t alignment)
+{
+  return new_impl(n, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+  free(p);
+}
+
+eos::common::AllocStats eos::common::GetAllocStats()
+{
+  return tStats;
+}
+
+void eos::common::ResetAllocPeak()
+{
+  tStats.peak = tStats.live;
+}
+
+// the timed runs, possibly multi threaded, skip the scope
+void eos::common::BeginAllocScope()
+{
+  if (armed()) {
+    gMemoryManager.begin_scope();
+  }
+}
+
+void eos::common::EndAllocScope()
+{
+  if (armed()) {
+    gMemoryManager.end_scope();
+  }
+}
+
+#else
+
+eos::common::AllocStats eos::common::GetAllocStats()
+{
+  return {};
+}
+
+void eos::common::ResetAllocPeak() {}
+void eos::common::BeginAllocScope() {}
+void eos::common::EndAllocScope() {}
+
+#endif
+
+namespace {
+
+//----------------------------------------------------------------------------
+// Display reporter adding the memory manager results to the counters of the
+// runs, so that they show on the console and not only in the JSON output.
+// The repetitions and aggregates of a benchmark share the results of its
+// last run, the allocations do not vary between runs. Spreads get none.
+//----------------------------------------------------------------------------
+class AllocCountersReporter : public benchmark::BenchmarkReporter {
+public:
+  explicit AllocCountersReporter(benchmark::BenchmarkReporter* display) :
+    display(display) {}
+
+  bool ReportContext(const Context& context) override {
+    return display->ReportContext(context);
+  }
+
+  void ReportRuns(const std::vector<Run>& runs) override {
+    // up to google benchmark 1.7 only the memory result of the last
+    // repetition is still valid, the others point into a reallocated vector
+    auto last = std::find_if(runs.rbegin(), runs.rend(), [](const Run& run) {
+      return run.run_type == Run::RT_Iteration;
+    });
+    if (last != runs.rend()) {
+      measured_name = last->run_name.str();
+      measured = read_counters(*last);
+    }
+
+    auto annotated = runs;
+    for (auto& run: annotated) {
+      if (measured && run.run_name.str() == measured_name &&
+          run.aggregate_name != "stddev" && run.aggregate_name != "cv") {
+        run.counters["allocs"] = measured->allocs;
+        run.counters["alloc_bytes"] = measured->bytes;
+        run.counters["peak_bytes"] = measured->peak;
+      }
+    }
+    display->ReportRuns(annotated);
+  }
+
+  void Finalize() override {
+    display->Finalize();
+  }
+
+private:
+  struct Counters {
+    double allocs;
+    double bytes;
+    double peak;
+  };
+
+  // Run::memory_result is a pointer before google benchmark 1.8
+  static const benchmark::MemoryManager::Result*
+  memory_result(const benchmark::MemoryManager::Result* r) {
+    return r;
+  }
+
+  static const benchmark::MemoryManager::Result*
+  memory_result(const benchmark::MemoryManager::Result& r) {
+    return &r;
+  }
+
+  static std::optional<Counters> read_counters(const Run& run) {
+    // MemoryManager::TombstoneValue, which not every build of the library
+    // exports, marks a run without an AllocCounters scope
+    constexpr int64_t kTombstone = std::numeric_limits<int64_t>::max();
+    auto r = memory_result(run.memory_result);
+    if (!r || r->total_allocated_bytes == kTombstone) {
+      return std::nullopt;
+    }
+    // the iterations of the memory run are only known through the average
+    double iterations = r->num_allocs ?
+                        std::round(r->num_allocs / run.allocs_per_iter) : 1;
+    return Counters {run.allocs_per_iter, r->total_allocated_bytes / iterations,
+                     double(r->max_bytes_used)};
+  }
+
+  std::unique_ptr<benchmark::BenchmarkReporter> display;
+  std::string measured_name;
+  std::optional<Counters> measured;
+};
+
+} // namespace
+
+size_t eos::common::RunSpecifiedBenchmarks()
+{
+#if EOS_ALLOC_COUNTERS
+  benchmark::RegisterMemoryManager(&gMemoryManager);
+#endif
+  AllocCountersReporter reporter(benchmark::CreateDefaultDisplayReporter());
+  auto n = benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::RegisterMemoryManager(nullptr);
+  return n;
+}
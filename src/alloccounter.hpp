@@ -0,0 +1,106 @@
+// ----------------------------------------------------------------------
+// File: alloccounter.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include "benchmark/benchmark.h"
+
+// set by the alloccounter target, see MICROBENCH_ALLOC_COUNTERS
+#ifndef EOS_ALLOC_COUNTERS
+#define EOS_ALLOC_COUNTERS 0
+#endif
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Heap usage of one thread as seen by the malloc and operator new hooks of
+//! alloccounter.cpp while they are armed. Sizes are the usable sizes of the
+//! blocks. Live bytes can go negative on a thread freeing memory allocated
+//! by another one, or allocated before the hooks were armed.
+//----------------------------------------------------------------------------
+struct AllocStats {
+  uint64_t allocs {0};
+  uint64_t bytes {0};
+  int64_t live {0};
+  int64_t peak {0};
+};
+
+//! Counters of the calling thread, all zero when built without the hooks
+AllocStats GetAllocStats();
+
+//! Restart the peak of the calling thread from its current live bytes
+void ResetAllocPeak();
+
+//! Mark the start and the end of the timing loop, see AllocCounters
+void BeginAllocScope();
+void EndAllocScope();
+
+//----------------------------------------------------------------------------
+//! Marks the timing loop of a benchmark as the part whose heap usage is
+//! reported. Construct it right before the loop:
+//!
+//!   eos::common::AllocCounters allocs(state);
+//!   for (auto _: state) { ... }
+//!
+//! The hooks only count during the separate memory measurement run that
+//! google benchmark does after the timed ones, see RunSpecifiedBenchmarks
+//! below, so the timings are unaffected. That run is reported as the
+//! counters allocs and alloc_bytes per iteration and peak_bytes, the
+//! highest live bytes above the start of the loop. Benchmarks without an
+//! AllocCounters report none.
+//----------------------------------------------------------------------------
+class AllocCounters {
+public:
+  explicit AllocCounters(benchmark::State&) {
+    BeginAllocScope();
+  }
+
+  AllocCounters(const AllocCounters&) = delete;
+  AllocCounters& operator=(const AllocCounters&) = delete;
+
+  ~AllocCounters() {
+    EndAllocScope();
+  }
+};
+
+//----------------------------------------------------------------------------
+//! benchmark::RunSpecifiedBenchmarks with the allocation counters: registers
+//! the memory manager arming the hooks, and adds its results to the
+//! counters shown by the display reporter. Without the hooks it only runs
+//! the benchmarks.
+//----------------------------------------------------------------------------
+size_t RunSpecifiedBenchmarks();
+
+} // namespace eos::common
+
+//! BENCHMARK_MAIN running eos::common::RunSpecifiedBenchmarks
+#define EOS_BENCHMARK_MAIN()                                            \
+  int main(int argc, char** argv) {                                     \
+    ::benchmark::Initialize(&argc, argv);                               \
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) return 1; \
+    ::eos::common::RunSpecifiedBenchmarks();                            \
+    ::benchmark::Shutdown();                                            \
+    return 0;                                                           \
+  }                                                                     \
+  int main(int, char**)
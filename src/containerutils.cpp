@@ -0,0 +1,131 @@
+#include <deque>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "containerutils.hpp"
+#include "benchmark/benchmark.h"
+
+// The element by element versions the helpers used to be, as a baseline
+namespace naive {
+
+template <typename C>
+void splice(C& c, C&& other)
+{
+  if constexpr (eos::common::detail::has_key_type<C>::value) {
+    c.insert(std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+  } else {
+    c.insert(c.end(),
+             std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+  }
+}
+
+template <typename C, typename Pred>
+typename C::size_type erase_if(C& c, Pred pred)
+{
+  auto init_sz = c.size();
+  for (auto it = c.begin(), last = c.end(); it != last;) {
+    if (pred(*it)) {
+      it = c.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return init_sz - c.size();
+}
+
+} // namespace naive
+
+// n elements with the values first, first + stride, ...
+template <typename C>
+static C MakeContainer(int64_t n, int64_t first, int64_t stride = 1)
+{
+  C c;
+  for (int64_t i = 0; i < n; i++) {
+    auto v = first + i * stride;
+    if constexpr (eos::common::detail::has_key_type<C>::value) {
+      c.emplace(v, v);
+    } else {
+      c.push_back(v);
+    }
+  }
+  return c;
+}
+
+static int64_t KeyOf(int64_t v) { return v; }
+template <typename K, typename V>
+static K KeyOf(const std::pair<const K, V>& kv) { return kv.first; }
+
+// Splice two halves of range(0) elements, only the splice is timed. The
+// keys interleave, so that ordered inserts can not just append at the end.
+template <typename C, bool naive_impl>
+static void BM_Splice(benchmark::State& state) {
+  auto n = state.range(0);
+  for (auto _: state) {
+    state.PauseTiming();
+    auto c = MakeContainer<C>(n / 2, 0, 2);
+    auto other = MakeContainer<C>(n - n / 2, 1, 2);
+    state.ResumeTiming();
+    if constexpr (naive_impl) {
+      naive::splice(c, std::move(other));
+    } else {
+      eos::common::splice(c, std::move(other));
+    }
+    benchmark::DoNotOptimize(c);
+    state.PauseTiming();
+    // destruction is not part of the splice
+    c = C();
+    other = C();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Erase every other element of range(0) elements
+template <typename C, bool naive_impl>
+static void BM_EraseIf(benchmark::State& state) {
+  auto n = state.range(0);
+  for (auto _: state) {
+    state.PauseTiming();
+    auto c = MakeContainer<C>(n, 0);
+    state.ResumeTiming();
+    auto pred = [](const auto& v) { return KeyOf(v) % 2 == 0; };
+    if constexpr (naive_impl) {
+      benchmark::DoNotOptimize(naive::erase_if(c, pred));
+    } else {
+      benchmark::DoNotOptimize(eos::common::erase_if(c, pred));
+    }
+    state.PauseTiming();
+    c = C();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+using IntVector = std::vector<int64_t>;
+using IntDeque = std::deque<int64_t>;
+using IntList = std::list<int64_t>;
+using IntMap = std::map<int64_t, int64_t>;
+using IntUMap = std::unordered_map<int64_t, int64_t>;
+
+#define CONTAINER_BENCHMARKS(C)                                                 \
+  BENCHMARK_TEMPLATE(BM_Splice, C, true)->RangeMultiplier(10)->Range(100, 1000000); \
+  BENCHMARK_TEMPLATE(BM_Splice, C, false)->RangeMultiplier(10)->Range(100, 1000000); \
+  BENCHMARK_TEMPLATE(BM_EraseIf, C, false)->RangeMultiplier(10)->Range(100, 1000000)
+
+CONTAINER_BENCHMARKS(IntVector);
+CONTAINER_BENCHMARKS(IntDeque);
+CONTAINER_BENCHMARKS(IntList);
+CONTAINER_BENCHMARKS(IntMap);
+CONTAINER_BENCHMARKS(IntUMap);
+
+// erasing element by element from the middle of a sequence is quadratic,
+// beyond 10^4 a single run takes seconds
+BENCHMARK_TEMPLATE(BM_EraseIf, IntVector, true)->RangeMultiplier(10)->Range(100, 10000);
+BENCHMARK_TEMPLATE(BM_EraseIf, IntDeque, true)->RangeMultiplier(10)->Range(100, 10000);
+BENCHMARK_TEMPLATE(BM_EraseIf, IntList, true)->RangeMultiplier(10)->Range(100, 1000000);
+BENCHMARK_TEMPLATE(BM_EraseIf, IntMap, true)->RangeMultiplier(10)->Range(100, 1000000);
+BENCHMARK_TEMPLATE(BM_EraseIf, IntUMap, true)->RangeMultiplier(10)->Range(100, 1000000);
+BENCHMARK_MAIN();
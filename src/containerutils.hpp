@@ -0,0 +1,191 @@
+// ----------------------------------------------------------------------
+// File: containerutils.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace eos::common {
+
+namespace detail {
+
+template <typename C, typename = void>
+struct has_node_splice : std::false_type {};
+
+// std::list
+template <typename C>
+struct has_node_splice<C, std::void_t<decltype(std::declval<C&>().splice(
+  std::declval<typename C::const_iterator>(), std::declval<C&>()))>>
+  : std::true_type {};
+
+template <typename C, typename = void>
+struct has_merge : std::false_type {};
+
+// node based associative containers, ordered or not
+template <typename C>
+struct has_merge<C, std::void_t<typename C::key_type, typename C::node_type,
+  decltype(std::declval<C&>().merge(std::declval<C&>()))>>
+  : std::true_type {};
+
+template <typename C, typename = void>
+struct has_member_remove_if : std::false_type {};
+
+// std::list and std::forward_list
+template <typename C>
+struct has_member_remove_if<C, std::void_t<decltype(std::declval<C&>().remove_if(
+  std::declval<bool(*)(const typename C::value_type&)>()))>>
+  : std::true_type {};
+
+template <typename C, typename = void>
+struct has_key_type : std::false_type {};
+
+template <typename C>
+struct has_key_type<C, std::void_t<typename C::key_type>> : std::true_type {};
+
+template <typename C, typename = void>
+struct has_size : std::false_type {};
+
+template <typename C>
+struct has_size<C, std::void_t<decltype(std::declval<const C&>().size())>>
+  : std::true_type {};
+
+// forward_list has no size()
+template <typename C>
+typename C::size_type count(const C& c)
+{
+  if constexpr (has_size<C>::value) {
+    return c.size();
+  } else {
+    return std::distance(c.begin(), c.end());
+  }
+}
+
+template <typename C>
+constexpr bool is_random_access_v = std::is_base_of_v<
+  std::random_access_iterator_tag,
+  typename std::iterator_traits<typename C::iterator>::iterator_category>;
+
+} // namespace detail
+
+//----------------------------------------------------------------------------
+//! Transfer a container onto another, this variants destructively move values
+//! from other container onto source container at a given pos. Lists relink
+//! their nodes, other sequences move their elements, or simply take over
+//! other's storage when c is empty.
+//! \tparam C sequence container type -  will be inferred
+//! \param c container where other container will be spliced onto
+//! \param other container whose elements will be consumed
+//! \param pos position where we need to splice
+//----------------------------------------------------------------------------
+template <typename C>
+void
+splice(C& c, C&& other,
+       typename C::const_iterator pos)
+{
+  static_assert(!detail::has_key_type<C>::value,
+                "associative containers have no position, use splice(c, other)");
+  if constexpr (detail::has_node_splice<C>::value) {
+    c.splice(pos, other);
+  } else {
+    if (c.empty()) {
+      c = std::move(other);
+      return;
+    }
+    c.insert(pos,
+             std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+  }
+}
+
+//----------------------------------------------------------------------------
+//! Transfer a container onto another at the end, this variants destructively move values
+//! from other container onto source container at a given pos. Node based
+//! associative containers move their nodes with merge(), like insert()
+//! elements whose keys are already present in c are not transferred and
+//! remain in other.
+//! \tparam C container type -  will be inferred
+//! \param c container where other container will be spliced onto
+//! \param other container whose elements will be consumed
+//----------------------------------------------------------------------------
+template <typename C>
+void splice(C& c, C&& other)
+{
+  if constexpr (detail::has_merge<C>::value) {
+    c.merge(other);
+  } else if constexpr (detail::has_key_type<C>::value) {
+    c.insert(std::make_move_iterator(other.begin()),
+             std::make_move_iterator(other.end()));
+  } else {
+    splice(c, std::move(other), c.end());
+  }
+}
+
+//----------------------------------------------------------------------------
+//! erase_if that erases elements in place for elements matching a predicate
+//! This is useful in erase remove idiom useful for assoc. containers where
+//! std::remove_if will not compile, almost borrowed from erase_if C++ ref page
+//! Picks the cheapest way per container: lists unlink with remove_if(),
+//! random access sequences compact with std::remove_if + a single erase
+//! instead of shifting the tail for every erased element, and associative
+//! containers erase node by node.
+//!
+//! @param C the container, elements will be removed in place
+//! @param pred the predicate to evaluate, please note the container
+//!             value_type aka the pair of values will be the input for the
+//!             predicate
+//! @return the no of elements removed
+//! Usage eg:
+//!   eos::common::erase_if(m, [](const auto& p){ return p.first % 2 == 0;})
+//----------------------------------------------------------------------------
+template <typename C, typename Pred>
+typename C::size_type
+erase_if(C& c, Pred pred)
+{
+  if constexpr (detail::has_member_remove_if<C>::value) {
+    auto init_sz = detail::count(c);
+    c.remove_if(pred);
+    return init_sz - detail::count(c);
+  } else if constexpr (!detail::has_key_type<C>::value &&
+                       detail::is_random_access_v<C>) {
+    auto it = std::remove_if(c.begin(), c.end(), pred);
+    auto n = std::distance(it, c.end());
+    c.erase(it, c.end());
+    return n;
+  } else {
+    auto init_sz = c.size();
+    for (auto it = c.begin(), last = c.end(); it != last;) {
+      if (pred(*it)) {
+        it = c.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return init_sz - c.size();
+  }
+}
+
+
+} // namespace eos::common
@@ -1,10 +1,32 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include "alloccounter.hpp"
+#include "fixedstring.hpp"
+#include "flatpolicymap.hpp"
+#include "mappedmap.hpp"
+#include "rcupolicystore.hpp"
+#include "shardedmap.hpp"
+#include "swissmap.hpp"
+#include "versionedpolicy.hpp"
 #include "benchmark/benchmark.h"
 
+using Key = eos::common::FixedString<24>;
+
+template <typename Map = std::map<std::string, std::string>>
 static void BM_Count(benchmark::State& state) {
-  std::map<std::string, std::string> m;
+  Map m;
   auto sz = state.range(0);
   for(auto i =0; i < sz; i++) {
     std::string key = "key" + std::to_string(i);
@@ -12,6 +34,7 @@ static void BM_Count(benchmark::State& state) {
     m.emplace(std::make_pair(std::move(key),std::move(val)));
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _ : state) {
     for (auto i=0; i < sz; i++) {
       std::string key = "key" + std::to_string(i);
@@ -22,8 +45,9 @@ static void BM_Count(benchmark::State& state) {
   }
 }
 
+template <typename Map = std::map<std::string, std::string>>
 static void BM_find(benchmark::State& state) {
-  std::map<std::string, std::string> m;
+  Map m;
   auto sz = state.range(0);
   for(auto i =0; i < sz; i++) {
     std::string key = "key" + std::to_string(i);
@@ -31,9 +55,122 @@ static void BM_find(benchmark::State& state) {
     m.emplace(std::move(key),std::move(val));
   }
 
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (auto i=0; i < sz; i++) {
+      std::string key = "key" + std::to_string(i);
+      if(auto kv = m.find(key); kv != m.end()) {
+        std::string val = kv->second;
+      }
+    }
+  }
+}
+
+// Key construction alone, std::string vs formatting in place
+static void BM_MakeKey(benchmark::State& state) {
+  auto sz = state.range(0);
+  eos::common::AllocCounters allocs(state);
   for (auto _ : state) {
     for (auto i=0; i < sz; i++) {
       std::string key = "key" + std::to_string(i);
+      benchmark::DoNotOptimize(key);
+    }
+  }
+}
+
+static void BM_MakeFixedKey(benchmark::State& state) {
+  auto sz = state.range(0);
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (auto i=0; i < sz; i++) {
+      auto key = Key::format("key", i);
+      benchmark::DoNotOptimize(key);
+    }
+  }
+}
+
+// Same as BM_Count and BM_find with the keys built before the loop, so only
+// the lookups are measured
+static std::vector<std::string> MakeKeys(int64_t sz)
+{
+  std::vector<std::string> keys;
+  keys.reserve(sz);
+  for (auto i=0; i < sz; i++) {
+    keys.push_back("key" + std::to_string(i));
+  }
+  return keys;
+}
+
+template <typename Map = std::map<std::string, std::string>>
+static void BM_CountPrebuilt(benchmark::State& state) {
+  Map m;
+  auto sz = state.range(0);
+  auto keys = MakeKeys(sz);
+  for(auto i =0; i < sz; i++) {
+    m.emplace(keys[i], "val" + std::to_string(i));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (const auto& key: keys) {
+      if(m.count(key)) {
+        std::string val = m[key];
+      }
+    }
+  }
+}
+
+template <typename Map = std::map<std::string, std::string>>
+static void BM_findPrebuilt(benchmark::State& state) {
+  Map m;
+  auto sz = state.range(0);
+  auto keys = MakeKeys(sz);
+  for(auto i =0; i < sz; i++) {
+    m.emplace(keys[i], "val" + std::to_string(i));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (const auto& key: keys) {
+      if(auto kv = m.find(key); kv != m.end()) {
+        std::string val = kv->second;
+      }
+    }
+  }
+}
+
+// std::string keys probed with a FixedString through a transparent
+// comparator, so the probe key does not allocate
+static void BM_findTransparent(benchmark::State& state) {
+  std::map<std::string, std::string, std::less<>> m;
+  auto sz = state.range(0);
+  for(auto i =0; i < sz; i++) {
+    m.emplace("key" + std::to_string(i), "val" + std::to_string(i));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (auto i=0; i < sz; i++) {
+      auto key = Key::format("key", i);
+      if(auto kv = m.find(key.view()); kv != m.end()) {
+        std::string val = kv->second;
+      }
+    }
+  }
+}
+
+// FixedString keys throughout
+static void BM_findFixed(benchmark::State& state) {
+  std::map<Key, std::string> m;
+  auto sz = state.range(0);
+  for(auto i =0; i < sz; i++) {
+    m.emplace(Key::format("key", i), "val" + std::to_string(i));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (auto i=0; i < sz; i++) {
+      auto key = Key::format("key", i);
       if(auto kv = m.find(key); kv != m.end()) {
         std::string val = kv->second;
       }
@@ -41,8 +178,466 @@ static void BM_find(benchmark::State& state) {
   }
 }
 
+// Allocator counting the bytes held by the std containers below, the keys
+// and values are short enough to stay in the std::string inline buffer
+static std::atomic<size_t> gContainerBytes {0};
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    gContainerBytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    gContainerBytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using KV = std::pair<const std::string, std::string>;
+
+// The containers under test behind one interface: build from sorted keys,
+// find returning the value or nullptr, and the bytes held
+struct StdMap {
+  std::map<std::string, std::string, std::less<>, CountingAllocator<KV>> m;
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      m.emplace(keys[i], vals[i]);
+    }
+  }
+
+  const std::string* find(const std::string& key) const {
+    auto kv = m.find(key);
+    return kv != m.end() ? &kv->second : nullptr;
+  }
+
+  size_t memory() const { return gContainerBytes; }
+};
+
+template <bool reserve>
+struct StdUnorderedMap {
+  std::unordered_map<std::string, std::string, std::hash<std::string>,
+                     std::equal_to<std::string>, CountingAllocator<KV>> m;
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    if (reserve) {
+      m.reserve(keys.size());
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+      m.emplace(keys[i], vals[i]);
+    }
+  }
+
+  const std::string* find(const std::string& key) const {
+    auto kv = m.find(key);
+    return kv != m.end() ? &kv->second : nullptr;
+  }
+
+  size_t memory() const { return gContainerBytes; }
+};
+
+struct SortedVector {
+  std::vector<std::pair<std::string, std::string>> v;
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    v.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      v.emplace_back(keys[i], vals[i]);
+    }
+    std::sort(v.begin(), v.end());
+  }
+
+  const std::string* find(const std::string& key) const {
+    auto it = std::lower_bound(v.begin(), v.end(), key,
+                               [](const auto& kv, const std::string& k) {
+                                 return kv.first < k;
+                               });
+    return it != v.end() && it->first == key ? &it->second : nullptr;
+  }
+
+  size_t memory() const { return v.capacity() * sizeof(v[0]); }
+};
+
+// the in-tree open addressing table
+struct FlatMap {
+  eos::common::FlatPolicyMap m;
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      m.insert_or_assign(keys[i], vals[i]);
+    }
+  }
+
+  std::optional<std::string_view> find(const std::string& key) const {
+    return m.find(key);
+  }
+
+  size_t memory() const { return m.memory_usage(); }
+};
+
+struct SwissMap {
+  eos::common::SwissStringMap m;
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      m.emplace(keys[i], vals[i]);
+    }
+  }
+
+  const std::string* find(const std::string& key) const {
+    auto kv = m.find(key);
+    return kv != m.end() ? &kv->second : nullptr;
+  }
+
+  size_t memory() const { return m.memory_usage(); }
+};
+
+static std::string TempMapPath(const std::string& name)
+{
+  auto file = "findvscount-" + std::to_string(::getpid()) + "-" + name + ".map";
+  return (std::filesystem::temp_directory_path() / file).string();
+}
+
+// the map is written to a file which is mapped and unlinked right away
+template <bool hash_index>
+struct MappedMap {
+  std::optional<eos::common::MappedStringMap> m;
+  size_t file_size {0};
+
+  void build(std::vector<std::string>& keys, std::vector<std::string>& vals) {
+    std::vector<std::pair<std::string_view, std::string_view>> kvs;
+    kvs.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      kvs.emplace_back(keys[i], vals[i]);
+    }
+    auto path = TempMapPath("lookup");
+    eos::common::MappedStringMap::write(path, kvs, hash_index);
+    m.emplace(path);
+    file_size = std::filesystem::file_size(path);
+    std::remove(path.c_str());
+  }
+
+  std::optional<std::string_view> find(const std::string& key) const {
+    return m->find(key);
+  }
+
+  size_t memory() const { return file_size; }
+};
+
+// range(0) entries, range(1) out of 10 lookups hit. Misses look like the
+// stored keys; the probe keys are built before the loop.
+template <typename Container>
+static void BM_Lookup(benchmark::State& state) {
+  auto sz = state.range(0);
+  auto hit_tenths = state.range(1);
+  std::vector<std::string> keys, vals, probes;
+  keys.reserve(sz);
+  vals.reserve(sz);
+  probes.reserve(sz);
+  for (int64_t i = 0; i < sz; i++) {
+    keys.push_back("key" + std::to_string(i));
+    vals.push_back("val" + std::to_string(i));
+  }
+  for (int64_t i = 0; i < sz; i++) {
+    // spread the misses, and the hits over the whole key range
+    auto j = (i * 7919) % sz;
+    probes.push_back(i % 10 < hit_tenths ? keys[j] : "key" + std::to_string(sz + j));
+  }
+
+  gContainerBytes = 0;
+  auto c = std::make_unique<Container>();
+  c->build(keys, vals);
+  state.counters["bytes_per_entry"] = double(c->memory()) / sz;
+  keys = {};
+  vals = {};
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    for (const auto& key: probes) {
+      benchmark::DoNotOptimize(c->find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * sz);
+}
+
+static void LookupArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"entries", "hit_tenths"})
+   ->ArgsProduct({benchmark::CreateRange(1, 1 << 24, 16), {10, 5, 1}})
+   ->Unit(benchmark::kMillisecond);
+}
+
+// The table of the last BM_FindBatch run, only one is kept since the 16M
+// entry ones take gigabytes
+static std::shared_ptr<const void> gBatchTable;
+static std::pair<const void*, int64_t> gBatchTableId;
+
+template <typename Map>
+static void FillBatchTable(Map& m, int64_t entries)
+{
+  for (int64_t i = 0; i < entries; i++) {
+    m.insert_or_assign("key" + std::to_string(i), "val" + std::to_string(i));
+  }
+}
+
+// the stores copy their snapshot on every update, so fill them in one
+static void FillBatchTable(eos::common::RcuPolicyStore& store, int64_t entries)
+{
+  store.update([&](auto& m) { FillBatchTable(m, entries); });
+}
+
+static void FillBatchTable(eos::common::VersionedPolicyStore& store,
+                           int64_t entries)
+{
+  store.update([&](auto& batch) { FillBatchTable(batch, entries); });
+}
+
+template <typename Map>
+static const Map& BatchTable(int64_t entries)
+{
+  static const char type_tag = 0;
+  if (gBatchTableId != std::make_pair<const void*>(&type_tag, entries)) {
+    gBatchTable.reset();
+    auto m = std::make_shared<Map>();
+    FillBatchTable(*m, entries);
+    gBatchTable = m;
+    gBatchTableId = {&type_tag, entries};
+  }
+  return *static_cast<const Map*>(gBatchTable.get());
+}
+
+static std::optional<std::string_view>
+FindOne(const eos::common::FlatPolicyMap& m, std::string_view key)
+{
+  return m.find(key);
+}
+
+static std::optional<std::string_view>
+FindOne(const eos::common::SwissStringMap& m, std::string_view key)
+{
+  if (auto kv = m.find(key); kv != m.end()) {
+    return kv->second;
+  }
+  return std::nullopt;
+}
+
+// range(0) keys looked up at a time, in a table of range(1) entries; the
+// same random keys are looked up one by one or with find_batch
+template <typename Map, bool batched>
+static void BM_FindBatch(benchmark::State& state) {
+  constexpr size_t kLookups = 1 << 14;
+  size_t batch = state.range(0);
+  const auto& m = BatchTable<Map>(state.range(1));
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<int64_t> pick(0, state.range(1) - 1);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kLookups; i++) {
+    keys.push_back("key" + std::to_string(pick(gen)));
+  }
+  std::vector<std::optional<std::string_view>> out(batch);
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (size_t base = 0; base + batch <= kLookups; base += batch) {
+      auto first = keys.begin() + base;
+      if constexpr (batched) {
+        m.find_batch(first, first + batch, out.begin());
+      } else {
+        for (size_t i = 0; i < batch; i++) {
+          out[i] = FindOne(m, first[i]);
+        }
+      }
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (kLookups / batch * batch));
+}
+
+static void FindBatchArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch", "entries"})
+   ->ArgsProduct({benchmark::CreateRange(1, 256, 4),
+                  benchmark::CreateRange(1 << 10, 1 << 24, 16)});
+}
+
+// BM_FindBatch on the policy stores: one read() per key, copying the value
+// out before the snapshot is released, against one find_batch per batch
+template <typename Store, bool batched>
+static void BM_StoreFindBatch(benchmark::State& state) {
+  constexpr size_t kLookups = 1 << 14;
+  size_t batch = state.range(0);
+  const auto& store = BatchTable<Store>(state.range(1));
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<int64_t> pick(0, state.range(1) - 1);
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kLookups; i++) {
+    keys.push_back("key" + std::to_string(pick(gen)));
+  }
+  std::vector<std::string> out(batch);
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (size_t base = 0; base + batch <= kLookups; base += batch) {
+      auto first = keys.begin() + base;
+      if constexpr (batched) {
+        store.find_batch(first, first + batch, out.begin());
+      } else {
+        for (size_t i = 0; i < batch; i++) {
+          store.read([&](const eos::common::FlatPolicyMap& m) {
+            out[i].assign(m.find(first[i]).value_or(std::string_view()));
+          });
+        }
+      }
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (kLookups / batch * batch));
+}
+
+// One map shared by the threads of a run, range(1) shards holding
+// kConcurrentEntries keys, built in Setup so every thread starts on it
+static constexpr int64_t kConcurrentEntries = 1 << 16;
+template <typename Map>
+struct ConcurrentMapFixture {
+  static inline std::unique_ptr<Map> map;
+
+  static void Setup(const benchmark::State& state) {
+    map = std::make_unique<Map>(state.range(1));
+    for (auto i = 0; i < kConcurrentEntries; i++) {
+      map->insert_or_assign(Key::format("key", i), Key::format("val", i));
+    }
+  }
+
+  static void Teardown(const benchmark::State&) {
+    map.reset();
+  }
+};
+
+// Uniformly random keys, range(0) percent of the operations are reads and
+// the rest overwrite a value
+template <typename Map>
+static void BM_ConcurrentMap(benchmark::State& state) {
+  const auto& map = ConcurrentMapFixture<Map>::map;
+  auto read_pct = state.range(0);
+  std::mt19937_64 gen(42 + state.thread_index());
+  std::uniform_int_distribution<int64_t> pick(0, kConcurrentEntries - 1);
+  std::uniform_int_distribution<int64_t> percent(0, 99);
+  for (auto _: state) {
+    auto i = pick(gen);
+    auto key = Key::format("key", i);
+    if (percent(gen) < read_pct) {
+      map->visit(key, [](std::string_view v) {
+        benchmark::DoNotOptimize(v.data());
+      });
+    } else {
+      map->insert_or_assign(key, Key::format("val", i));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void ConcurrentMapArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"read_pct", "shards"})
+   ->ArgsProduct({{100, 95, 50}, {1, 16, 256}})
+   ->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+   ->UseRealTime();
+}
+
+// Time to the first lookup of a restarting daemon with range(0) entries:
+// building a std::map from scratch, or mapping a file written beforehand.
+// The file is in the page cache, so this is a warm restart.
+static void BM_FirstLookupBuild(benchmark::State& state) {
+  auto sz = state.range(0);
+  auto keys = MakeKeys(sz);
+  std::vector<std::string> vals;
+  for (auto i = 0; i < sz; i++) {
+    vals.push_back("val" + std::to_string(i));
+  }
+
+  for (auto _: state) {
+    auto m = std::make_unique<std::map<std::string, std::string>>();
+    for (auto i = 0; i < sz; i++) {
+      m->emplace(keys[i], vals[i]);
+    }
+    benchmark::DoNotOptimize(m->find(keys[sz / 2]));
+    state.PauseTiming();
+    m.reset();
+    state.ResumeTiming();
+  }
+}
+
+template <bool hash_index>
+static void BM_FirstLookupMapped(benchmark::State& state) {
+  auto sz = state.range(0);
+  auto path = TempMapPath("first" + std::to_string(sz));
+  {
+    std::map<std::string, std::string> m;
+    for (auto i = 0; i < sz; i++) {
+      m.emplace("key" + std::to_string(i), "val" + std::to_string(i));
+    }
+    eos::common::MappedStringMap::write(path, m, hash_index);
+  }
+  auto key = "key" + std::to_string(sz / 2);
+
+  for (auto _: state) {
+    eos::common::MappedStringMap m(path);
+    benchmark::DoNotOptimize(m.find(key));
+  }
+  std::remove(path.c_str());
+}
+
 uint64_t start = 1;
 uint64_t end = 1<<24UL;
-BENCHMARK(BM_Count)->Range(start, end)->Unit(benchmark::kMillisecond);
-BENCHMARK(BM_find)->Range(start, end)->Unit(benchmark::kMillisecond);
-BENCHMARK_MAIN();
+BENCHMARK(BM_Count<>)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Count, eos::common::SwissStringMap)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_find<>)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_find, eos::common::SwissStringMap)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MakeKey)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MakeFixedKey)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CountPrebuilt<>)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CountPrebuilt, eos::common::SwissStringMap)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_findPrebuilt<>)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_findPrebuilt, eos::common::SwissStringMap)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_findTransparent)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_findFixed)->Range(start, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Lookup, StdMap)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, StdUnorderedMap<false>)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, StdUnorderedMap<true>)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, SortedVector)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, FlatMap)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, SwissMap)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, MappedMap<true>)->Apply(LookupArgs);
+BENCHMARK_TEMPLATE(BM_Lookup, MappedMap<false>)->Apply(LookupArgs);
+BENCHMARK(BM_FirstLookupBuild)->RangeMultiplier(16)->Range(1 << 10, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FirstLookupMapped, true)->RangeMultiplier(16)->Range(1 << 10, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FirstLookupMapped, false)->RangeMultiplier(16)->Range(1 << 10, end)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FindBatch, eos::common::FlatPolicyMap, false)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_FindBatch, eos::common::FlatPolicyMap, true)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_FindBatch, eos::common::SwissStringMap, false)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_FindBatch, eos::common::SwissStringMap, true)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_StoreFindBatch, eos::common::RcuPolicyStore, false)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_StoreFindBatch, eos::common::RcuPolicyStore, true)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_StoreFindBatch, eos::common::VersionedPolicyStore, false)->Apply(FindBatchArgs);
+BENCHMARK_TEMPLATE(BM_StoreFindBatch, eos::common::VersionedPolicyStore, true)->Apply(FindBatchArgs);
+using SharedShardedMap = eos::common::ShardedStringMap<std::shared_mutex>;
+using MutexShardedMap = eos::common::ShardedStringMap<std::mutex>;
+BENCHMARK_TEMPLATE(BM_ConcurrentMap, SharedShardedMap)
+  ->Setup(ConcurrentMapFixture<SharedShardedMap>::Setup)
+  ->Teardown(ConcurrentMapFixture<SharedShardedMap>::Teardown)
+  ->Apply(ConcurrentMapArgs);
+BENCHMARK_TEMPLATE(BM_ConcurrentMap, MutexShardedMap)
+  ->Setup(ConcurrentMapFixture<MutexShardedMap>::Setup)
+  ->Teardown(ConcurrentMapFixture<MutexShardedMap>::Teardown)
+  ->Apply(ConcurrentMapArgs);
+EOS_BENCHMARK_MAIN();
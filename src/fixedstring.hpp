@@ -0,0 +1,173 @@
+// ----------------------------------------------------------------------
+// File: fixedstring.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! A string of at most N chars stored inline, for small keys such as
+//! "key1234" that would otherwise be built into a fresh std::string for
+//! every lookup. Always NUL terminated. Comparison is constexpr and, like
+//! std::hash, matches that of std::string_view, so it can be used to probe
+//! maps keyed by std::string given a transparent comparator or hash.
+//! Exceeding the capacity throws std::length_error.
+//----------------------------------------------------------------------------
+template <size_t N>
+class FixedString {
+public:
+  static_assert(N < 256, "the length is kept in a byte");
+
+  constexpr FixedString() = default;
+
+  constexpr FixedString(std::string_view s) {
+    append(s);
+  }
+
+  constexpr FixedString(const char* s) : FixedString(std::string_view(s)) {}
+
+  constexpr FixedString& append(std::string_view s) {
+    if (s.size() > N - len) {
+      throw std::length_error("FixedString capacity exceeded");
+    }
+    for (char c: s) {
+      buf[len++] = c;
+    }
+    buf[len] = '\0';
+    return *this;
+  }
+
+  constexpr FixedString& append(char c) {
+    return append(std::string_view(&c, 1));
+  }
+
+  //--------------------------------------------------------------------------
+  //! Append the decimal representation of n, like std::to_string would
+  //--------------------------------------------------------------------------
+  constexpr FixedString& append_number(uint64_t n) {
+    char digits[20] {};
+    size_t i = sizeof(digits);
+    do {
+      digits[--i] = '0' + n % 10;
+      n /= 10;
+    } while (n);
+    return append(std::string_view(digits + i, sizeof(digits) - i));
+  }
+
+  constexpr FixedString& append_number(int64_t n) {
+    if (n < 0) {
+      append('-');
+      return append_number(uint64_t(0) - uint64_t(n));
+    }
+    return append_number(uint64_t(n));
+  }
+
+  //--------------------------------------------------------------------------
+  //! Build prefix followed by the decimal n, eg. format("key", 42) -> "key42"
+  //--------------------------------------------------------------------------
+  template <typename Int>
+  static constexpr FixedString format(std::string_view prefix, Int n) {
+    FixedString s(prefix);
+    if constexpr (std::is_signed_v<Int>) {
+      s.append_number(int64_t(n));
+    } else {
+      s.append_number(uint64_t(n));
+    }
+    return s;
+  }
+
+  constexpr void clear() {
+    len = 0;
+    buf[0] = '\0';
+  }
+
+  constexpr const char* data() const { return buf; }
+  constexpr const char* c_str() const { return buf; }
+  constexpr size_t size() const { return len; }
+  constexpr bool empty() const { return len == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  constexpr std::string_view view() const { return {buf, len}; }
+  constexpr operator std::string_view() const { return view(); }
+  std::string str() const { return std::string(view()); }
+
+  //! FNV-1a, usable in constant expressions; not what std::hash returns
+  constexpr uint64_t fnv1a() const {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) {
+      h = (h ^ static_cast<unsigned char>(buf[i])) * 1099511628211ull;
+    }
+    return h;
+  }
+
+  friend constexpr bool operator==(const FixedString& a, const FixedString& b) {
+    return a.view() == b.view();
+  }
+
+  friend constexpr bool operator!=(const FixedString& a, const FixedString& b) {
+    return !(a == b);
+  }
+
+  friend constexpr bool operator<(const FixedString& a, const FixedString& b) {
+    return a.view() < b.view();
+  }
+
+  friend constexpr bool operator>(const FixedString& a, const FixedString& b) {
+    return b < a;
+  }
+
+  friend constexpr bool operator<=(const FixedString& a, const FixedString& b) {
+    return !(b < a);
+  }
+
+  friend constexpr bool operator>=(const FixedString& a, const FixedString& b) {
+    return !(a < b);
+  }
+
+private:
+  char buf[N + 1] {};
+  uint8_t len {0};
+};
+
+} // namespace eos::common
+
+namespace std {
+
+template <size_t N>
+struct hash<eos::common::FixedString<N>> {
+  // the same as for std::string_view, for heterogeneous lookups
+  size_t operator()(const eos::common::FixedString<N>& s) const {
+    return hash<string_view>{}(s.view());
+  }
+};
+
+} // namespace std
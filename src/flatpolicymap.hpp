@@ -0,0 +1,340 @@
+// ----------------------------------------------------------------------
+// File: flatpolicymap.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Flat string to string map for policy lookups. Keys and values are stored
+//! back to back in a single char arena, entries are kept densely in insertion
+//! order and indexed by a linear probing hash table of 32 bit entry indices,
+//! so a probe touches one slot array and one entry array instead of chasing
+//! tree nodes. Lookups take the key in two segments, see find().
+//!
+//! Views handed out by find() and for_each() are invalidated by any
+//! modification. Overwritten and erased data is reclaimed by compacting the
+//! arena once more than half of it is garbage. The arena is addressed with
+//! 32 bit offsets, so keys and values need to fit in 4 GiB in total.
+//----------------------------------------------------------------------------
+class FlatPolicyMap {
+public:
+  using size_type = size_t;
+  using value_type = std::pair<std::string_view, std::string_view>;
+
+  //! keys resolved together by find_batch()
+  static constexpr size_t kBatchGroup = 16;
+
+  //--------------------------------------------------------------------------
+  //! Insert or overwrite the value of a key
+  //!
+  //! @return true if the key was inserted, false if it was overwritten
+  //--------------------------------------------------------------------------
+  bool insert_or_assign(std::string_view key, std::string_view value) {
+    if ((entries.size() + 1) * 2 > slots.size()) {
+      rehash(slots.empty() ? 16 : slots.size() * 2);
+    }
+
+    auto h = hash(key, {});
+    auto i = probe(h, key, {});
+    if (slots[i] != kEmpty) {
+      auto& e = entries[slots[i]];
+      if (value.size() <= e.val_len) {
+        std::copy(value.begin(), value.end(), arena.begin() + e.val_off);
+        garbage += e.val_len - value.size();
+      } else {
+        garbage += e.val_len;
+        e.val_off = append(value);
+      }
+      e.val_len = value.size();
+      maybe_compact();
+      return false;
+    }
+
+    slots[i] = entries.size();
+    Entry e {h, append(key), static_cast<uint32_t>(key.size()), 0,
+             static_cast<uint32_t>(value.size())};
+    e.val_off = append(value);
+    entries.push_back(e);
+    return true;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup the key prefix + suffix, without concatenating them
+  //--------------------------------------------------------------------------
+  std::optional<std::string_view> find(std::string_view prefix,
+                                       std::string_view suffix = {}) const {
+    return find(prefix, suffix, hash(prefix, suffix));
+  }
+
+  //--------------------------------------------------------------------------
+  //! find() with the hash of prefix + suffix already computed
+  //--------------------------------------------------------------------------
+  std::optional<std::string_view> find(std::string_view prefix,
+                                       std::string_view suffix,
+                                       uint64_t h) const {
+    if (entries.empty()) {
+      return std::nullopt;
+    }
+
+    auto idx = slots[probe(h, prefix, suffix)];
+    if (idx == kEmpty) {
+      return std::nullopt;
+    }
+    return value_of(entries[idx]);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup the keys in [first, last), writing the results to out like
+  //! find(). The keys are taken kBatchGroup at a time: all of them hashed
+  //! with their slots prefetched, then their entries prefetched, then
+  //! resolved, so the cache misses of a group overlap instead of forming one
+  //! dependent chain per key.
+  //--------------------------------------------------------------------------
+  template <typename KeyIt, typename OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const {
+    uint64_t h[kBatchGroup];
+    while (first != last) {
+      size_t n = 0;
+      for (auto it = first; it != last && n < kBatchGroup; ++it, ++n) {
+        h[n] = hash(*it, {});
+        prefetch_slot(h[n]);
+      }
+      // reading the slot of a lone key only delays its own lookup
+      for (size_t i = 0; i < n && n > 1; i++) {
+        prefetch_entry(h[i]);
+      }
+      for (size_t i = 0; i < n; i++, ++first, ++out) {
+        *out = find(*first, {}, h[i]);
+      }
+    }
+    return out;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Prefetch hints for batched lookups of a hash: first the slot, then once
+  //! the slot is cached, the entry and its key it points to
+  //--------------------------------------------------------------------------
+  void prefetch_slot(uint64_t h) const {
+    if (!slots.empty()) {
+      __builtin_prefetch(&slots[h & (slots.size() - 1)]);
+    }
+  }
+
+  void prefetch_entry(uint64_t h) const {
+    if (slots.empty()) {
+      return;
+    }
+    if (auto idx = slots[h & (slots.size() - 1)]; idx != kEmpty) {
+      __builtin_prefetch(&entries[idx]);
+      __builtin_prefetch(arena.data() + entries[idx].key_off);
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  //! Erase all entries for which pred(value_type) holds, compacts the arena
+  //!
+  //! @return the number of entries removed
+  //--------------------------------------------------------------------------
+  template <typename Pred>
+  size_type erase_if(Pred pred) {
+    auto matches = [&](const Entry& e) {
+      return pred(value_type(key_of(e), value_of(e)));
+    };
+    // the common case of nothing to erase should not copy anything
+    auto first = std::find_if(entries.begin(), entries.end(), matches);
+    if (first == entries.end()) {
+      return 0;
+    }
+
+    std::vector<char> new_arena;
+    new_arena.reserve(arena.size() - garbage);
+    std::vector<Entry> kept(entries.begin(), first);
+    kept.reserve(entries.size());
+    for (auto& e: kept) {
+      move_entry(e, new_arena);
+    }
+    for (auto it = std::next(first); it != entries.end(); ++it) {
+      if (!matches(*it)) {
+        kept.push_back(*it);
+        move_entry(kept.back(), new_arena);
+      }
+    }
+
+    auto n = entries.size() - kept.size();
+    entries.swap(kept);
+    arena.swap(new_arena);
+    garbage = 0;
+    rehash(slots.size());
+    return n;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Call f(value_type) for every entry, in insertion order
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void for_each(F f) const {
+    for (const auto& e: entries) {
+      f(value_type(key_of(e), value_of(e)));
+    }
+  }
+
+  void clear() {
+    arena.clear();
+    entries.clear();
+    slots.clear();
+    garbage = 0;
+  }
+
+  size_type size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  //! heap bytes held, including spare capacity
+  size_t memory_usage() const {
+    return arena.capacity() + entries.capacity() * sizeof(Entry) +
+           slots.capacity() * sizeof(uint32_t);
+  }
+
+  //--------------------------------------------------------------------------
+  //! 64 bit FNV-1a of the key prefix + suffix, the same for any split
+  //--------------------------------------------------------------------------
+  static uint64_t hash(std::string_view prefix, std::string_view suffix) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : prefix) {
+      h = (h ^ c) * 1099511628211ull;
+    }
+    for (unsigned char c : suffix) {
+      h = (h ^ c) * 1099511628211ull;
+    }
+    // fold so the low bits see all of it
+    return h ^ (h >> 32);
+  }
+
+private:
+  static constexpr uint32_t kEmpty = UINT32_MAX;
+
+  struct Entry {
+    uint64_t hash;
+    uint32_t key_off;
+    uint32_t key_len;
+    uint32_t val_off;
+    uint32_t val_len;
+  };
+
+  std::string_view key_of(const Entry& e) const {
+    return {arena.data() + e.key_off, e.key_len};
+  }
+
+  std::string_view value_of(const Entry& e) const {
+    return {arena.data() + e.val_off, e.val_len};
+  }
+
+  // slot holding prefix + suffix, or the empty slot where it would go
+  size_t probe(uint64_t h, std::string_view prefix,
+               std::string_view suffix) const {
+    size_t mask = slots.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+      auto idx = slots[i];
+      if (idx == kEmpty) {
+        return i;
+      }
+      const auto& e = entries[idx];
+      if (e.hash == h && e.key_len == prefix.size() + suffix.size()) {
+        auto key = key_of(e);
+        if (key.substr(0, prefix.size()) == prefix &&
+            key.substr(prefix.size()) == suffix) {
+          return i;
+        }
+      }
+    }
+  }
+
+  uint32_t append(std::string_view s) {
+    auto off = arena.size();
+    arena.insert(arena.end(), s.begin(), s.end());
+    return off;
+  }
+
+  // copy the key and value of e into dst and point e at the copies
+  void move_entry(Entry& e, std::vector<char>& dst) const {
+    auto key_off = dst.size();
+    dst.insert(dst.end(), arena.begin() + e.key_off,
+               arena.begin() + e.key_off + e.key_len);
+    auto val_off = dst.size();
+    dst.insert(dst.end(), arena.begin() + e.val_off,
+               arena.begin() + e.val_off + e.val_len);
+    e.key_off = key_off;
+    e.val_off = val_off;
+  }
+
+  void maybe_compact() {
+    if (garbage < 4096 || garbage * 2 < arena.size()) {
+      return;
+    }
+
+    std::vector<char> new_arena;
+    new_arena.reserve(arena.size() - garbage);
+    for (auto& e: entries) {
+      move_entry(e, new_arena);
+    }
+    arena.swap(new_arena);
+    garbage = 0;
+  }
+
+  void rehash(size_t n) {
+    slots.assign(n, kEmpty);
+    size_t mask = n - 1;
+    for (uint32_t idx = 0; idx < entries.size(); idx++) {
+      size_t i = entries[idx].hash & mask;
+      while (slots[i] != kEmpty) {
+        i = (i + 1) & mask;
+      }
+      slots[i] = idx;
+    }
+  }
+
+  std::vector<char> arena;
+  std::vector<Entry> entries;
+  std::vector<uint32_t> slots;
+  size_t garbage {0};
+};
+
+//----------------------------------------------------------------------------
+//! erase_if for FlatPolicyMap, see the generic one in containerutils.hpp
+//----------------------------------------------------------------------------
+template <typename Pred>
+FlatPolicyMap::size_type erase_if(FlatPolicyMap& m, Pred pred)
+{
+  return m.erase_if(pred);
+}
+
+} // namespace eos::common
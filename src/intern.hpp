@@ -0,0 +1,269 @@
+// ----------------------------------------------------------------------
+// File: intern.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "lazysplit.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Concurrent intern table for path components. Every distinct string is
+//! stored once in a pooled arena and mapped to a stable 32 bit id, so a split
+//! path can be kept as a sequence of ids and compared or hashed without
+//! touching the characters.
+//!
+//! The table is sharded by hash, each shard has its own reader-writer lock,
+//! arena and id space; the low bits of an id encode the shard. The id to
+//! string table of a shard grows in chunks of doubling size that never move,
+//! so str() takes no lock. As usual ids must be obtained from intern() or
+//! lookup() (or handed over with proper synchronization) before calling str().
+//----------------------------------------------------------------------------
+class StringInterner {
+public:
+  static constexpr uint32_t kInvalidId = UINT32_MAX;
+
+  explicit StringInterner(size_t nshards = 16) {
+    while ((1UL << shard_bits) < nshards) {
+      ++shard_bits;
+    }
+    shards = std::make_unique<Shard[]>(1UL << shard_bits);
+  }
+
+  StringInterner(const StringInterner&) = delete;
+  StringInterner& operator=(const StringInterner&) = delete;
+
+  //--------------------------------------------------------------------------
+  //! Get the id of a string, inserting it if not yet known
+  //--------------------------------------------------------------------------
+  uint32_t intern(std::string_view s) {
+    auto h = std::hash<std::string_view>{}(s);
+    auto shard_idx = h & ((1UL << shard_bits) - 1);
+    auto& shard = shards[shard_idx];
+    {
+      std::shared_lock lock(shard.mtx);
+      if (auto it = shard.ids.find(s); it != shard.ids.end()) {
+        return it->second;
+      }
+    }
+
+    std::unique_lock lock(shard.mtx);
+    if (auto it = shard.ids.find(s); it != shard.ids.end()) {
+      return it->second;
+    }
+
+    auto local = shard.count;
+    auto pooled = shard.store(s);
+    shard.slot(local) = pooled;
+    shard.ids.emplace(pooled, make_id(shard_idx, local));
+    ++shard.count;
+    return make_id(shard_idx, local);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Get the id of a string without inserting it
+  //!
+  //! @return the id or kInvalidId if the string was never interned
+  //--------------------------------------------------------------------------
+  uint32_t lookup(std::string_view s) const {
+    auto h = std::hash<std::string_view>{}(s);
+    auto& shard = shards[h & ((1UL << shard_bits) - 1)];
+    std::shared_lock lock(shard.mtx);
+    auto it = shard.ids.find(s);
+    return it != shard.ids.end() ? it->second : kInvalidId;
+  }
+
+  //--------------------------------------------------------------------------
+  //! The pooled canonical string for an id
+  //--------------------------------------------------------------------------
+  std::string_view str(uint32_t id) const {
+    return shards[id & ((1UL << shard_bits) - 1)].slot(id >> shard_bits);
+  }
+
+  size_t size() const {
+    size_t n = 0;
+    for (size_t i = 0; i < (1UL << shard_bits); i++) {
+      std::shared_lock lock(shards[i].mtx);
+      n += shards[i].count;
+    }
+    return n;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Approximate heap usage in bytes, the hash index is estimated from its
+  //! node and bucket count
+  //--------------------------------------------------------------------------
+  size_t memory_usage() const {
+    size_t bytes = sizeof(*this);
+    for (size_t i = 0; i < (1UL << shard_bits); i++) {
+      auto& shard = shards[i];
+      std::shared_lock lock(shard.mtx);
+      bytes += sizeof(Shard) + shard.arena_bytes;
+      for (size_t c = 0; c < kMaxChunks && shard.chunks[c]; c++) {
+        bytes += chunk_size(c) * sizeof(std::string_view);
+      }
+      bytes += shard.ids.bucket_count() * sizeof(void*) +
+               shard.ids.size() * (sizeof(std::pair<std::string_view, uint32_t>) +
+                                   2 * sizeof(void*));
+    }
+    return bytes;
+  }
+
+private:
+  static constexpr size_t kFirstChunk = 64;
+  static constexpr size_t kMaxChunks = 32;
+  static constexpr size_t kArenaBlock = 16384;
+
+  static constexpr size_t chunk_size(size_t c) {
+    return kFirstChunk << c;
+  }
+
+  uint32_t make_id(size_t shard_idx, uint32_t local) const {
+    return (local << shard_bits) | shard_idx;
+  }
+
+  struct Shard {
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    // chunk c holds kFirstChunk << c slots, the chunks never move once
+    // published so readers index them without the lock
+    std::array<std::atomic<std::string_view*>, kMaxChunks> chunks {};
+    std::vector<std::unique_ptr<std::string_view[]>> chunk_storage;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cur {nullptr};
+    size_t used {0};
+    size_t cap {0};
+    size_t arena_bytes {0};
+    uint32_t count {0};
+
+    static void locate(uint32_t local, size_t& c, size_t& off) {
+      size_t n = local + kFirstChunk;
+      c = (63 - __builtin_clzll(n)) - (63 - __builtin_clzll(kFirstChunk));
+      off = n - (kFirstChunk << c);
+    }
+
+    std::string_view& slot(uint32_t local) {
+      size_t c, off;
+      locate(local, c, off);
+      auto chunk = chunks[c].load(std::memory_order_acquire);
+      if (!chunk) {
+        chunk_storage.emplace_back(new std::string_view[chunk_size(c)]);
+        chunk = chunk_storage.back().get();
+        chunks[c].store(chunk, std::memory_order_release);
+      }
+      return chunk[off];
+    }
+
+    std::string_view slot(uint32_t local) const {
+      size_t c, off;
+      locate(local, c, off);
+      return chunks[c].load(std::memory_order_acquire)[off];
+    }
+
+    std::string_view store(std::string_view s) {
+      if (s.size() > cap - used) {
+        cap = std::max(kArenaBlock, s.size());
+        blocks.emplace_back(new char[cap]);
+        cur = blocks.back().get();
+        used = 0;
+        arena_bytes += cap;
+      }
+      char* dst = cur + used;
+      std::memcpy(dst, s.data(), s.size());
+      used += s.size();
+      return {dst, s.size()};
+    }
+  };
+
+  size_t shard_bits {0};
+  std::unique_ptr<Shard[]> shards;
+};
+
+//----------------------------------------------------------------------------
+//! A path held as a sequence of interned component ids, equality and hashing
+//! work on the ids alone.
+//----------------------------------------------------------------------------
+struct InternedPath {
+  std::vector<uint32_t> ids;
+
+  friend bool operator==(const InternedPath& a, const InternedPath& b) {
+    return a.ids == b.ids;
+  }
+
+  friend bool operator!=(const InternedPath& a, const InternedPath& b) {
+    return !(a == b);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Rebuild the textual path, mainly for debugging and display
+  //--------------------------------------------------------------------------
+  std::string str(const StringInterner& interner) const {
+    std::string out;
+    for (auto id: ids) {
+      out += '/';
+      out += interner.str(id);
+    }
+    return out.empty() ? "/" : out;
+  }
+};
+
+struct InternedPathHash {
+  size_t operator()(const InternedPath& p) const {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (auto id: p.ids) {
+      h ^= id;
+      h *= 0x100000001b3ULL;
+    }
+    return h;
+  }
+};
+
+//----------------------------------------------------------------------------
+//! Split a path on '/' directly into interned component ids
+//!
+//! @param interner the intern table, unknown components are inserted
+//! @param path the path to split
+//! @param out the path whose ids are replaced
+//----------------------------------------------------------------------------
+inline void InternSplit(StringInterner& interner, std::string_view path,
+                        InternedPath& out)
+{
+  out.ids.clear();
+  for (auto c: LazySplit<std::string_view, char>(path, '/')) {
+    out.ids.push_back(interner.intern(c));
+  }
+}
+
+} // namespace eos::common
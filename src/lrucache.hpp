@@ -0,0 +1,226 @@
+// ----------------------------------------------------------------------
+// File: lrucache.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Bounded, string keyed LRU cache of immutable values. The cache is split
+//! into shards by key hash, each with its own lock, LRU list and an equal
+//! share of the memory budget. Values are handed out as shared_ptr<const V>,
+//! so an entry evicted while in use stays valid for its holders.
+//!
+//! @tparam V the cached type, must provide size_t footprint() const giving
+//!           its approximate heap usage in bytes
+//----------------------------------------------------------------------------
+template <typename V>
+class ShardedLruCache {
+public:
+  using value_type = std::shared_ptr<const V>;
+
+  struct Stats {
+    uint64_t hits {0};
+    uint64_t misses {0};
+    uint64_t evictions {0};
+    size_t bytes {0};
+    size_t entries {0};
+  };
+
+  //--------------------------------------------------------------------------
+  //! @param memory_budget approximate upper bound in bytes for all entries,
+  //!        including their keys and bookkeeping
+  //! @param nshards number of shards, rounded up to a power of 2
+  //--------------------------------------------------------------------------
+  explicit ShardedLruCache(size_t memory_budget, size_t nshards = 16) {
+    size_t n = 1;
+    while (n < nshards) {
+      n <<= 1;
+    }
+    shard_mask = n - 1;
+    shards = std::make_unique<Shard[]>(n);
+    for (size_t i = 0; i < n; i++) {
+      shards[i].budget = memory_budget / n;
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup a key without filling on a miss, misses are not counted
+  //--------------------------------------------------------------------------
+  value_type find(std::string_view key) {
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mtx);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      shard.hits.fetch_add(1, std::memory_order_relaxed);
+      return it->second->value;
+    }
+    return nullptr;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup a key, on a miss make(key) builds the value outside of the shard
+  //! lock, which is then inserted evicting least recently used entries. A
+  //! value that alone exceeds the shard budget is returned but not cached.
+  //--------------------------------------------------------------------------
+  template <typename F>
+  value_type get_or_create(std::string_view key, F&& make) {
+    auto& shard = shard_for(key);
+    {
+      std::lock_guard lock(shard.mtx);
+      if (auto it = shard.index.find(key); it != shard.index.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->value;
+      }
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    value_type value = make(key);
+    std::lock_guard lock(shard.mtx);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      // lost the race against another thread filling the same key
+      return it->second->value;
+    }
+
+    size_t bytes = kEntryOverhead + key.size() + value->footprint();
+    if (bytes > shard.budget) {
+      return value;
+    }
+
+    while (shard.bytes + bytes > shard.budget) {
+      evict(shard, std::prev(shard.lru.end()));
+      shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.lru.push_front({std::string(key), value, bytes});
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += bytes;
+    return value;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Drop the entry of a key, not counted as an eviction
+  //!
+  //! @return whether there was an entry
+  //--------------------------------------------------------------------------
+  bool erase(std::string_view key) {
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mtx);
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      evict(shard, it->second);
+      return true;
+    }
+    return false;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Drop all entries for which pred(key, value) holds, these are not counted
+  //! as evictions
+  //!
+  //! @return the number of entries dropped
+  //--------------------------------------------------------------------------
+  template <typename Pred>
+  size_t erase_if(Pred pred) {
+    size_t n = 0;
+    for (size_t i = 0; i <= shard_mask; i++) {
+      auto& shard = shards[i];
+      std::lock_guard lock(shard.mtx);
+      for (auto it = shard.lru.begin(); it != shard.lru.end();) {
+        if (pred(std::string_view(it->key), *it->value)) {
+          it = evict(shard, it);
+          ++n;
+        } else {
+          ++it;
+        }
+      }
+    }
+    return n;
+  }
+
+  void clear() {
+    erase_if([](std::string_view, const V&) { return true; });
+  }
+
+  Stats stats() const {
+    Stats s;
+    for (size_t i = 0; i <= shard_mask; i++) {
+      auto& shard = shards[i];
+      s.hits += shard.hits.load(std::memory_order_relaxed);
+      s.misses += shard.misses.load(std::memory_order_relaxed);
+      s.evictions += shard.evictions.load(std::memory_order_relaxed);
+      std::lock_guard lock(shard.mtx);
+      s.bytes += shard.bytes;
+      s.entries += shard.index.size();
+    }
+    return s;
+  }
+
+private:
+  // list node, hash node and bucket, roughly
+  static constexpr size_t kEntryOverhead = 96;
+
+  struct Entry {
+    std::string key;
+    value_type value;
+    size_t bytes;
+  };
+
+  using list_type = std::list<Entry>;
+
+  struct alignas(64) Shard {
+    mutable std::mutex mtx;
+    list_type lru;
+    // keyed by a view of the key owned by the list entry
+    std::unordered_map<std::string_view, typename list_type::iterator> index;
+    size_t bytes {0};
+    size_t budget {0};
+    std::atomic<uint64_t> hits {0};
+    std::atomic<uint64_t> misses {0};
+    std::atomic<uint64_t> evictions {0};
+  };
+
+  Shard& shard_for(std::string_view key) {
+    return shards[std::hash<std::string_view>{}(key) & shard_mask];
+  }
+
+  static typename list_type::iterator evict(Shard& shard,
+                                            typename list_type::iterator it) {
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->key);
+    return shard.lru.erase(it);
+  }
+
+  size_t shard_mask;
+  std::unique_ptr<Shard[]> shards;
+};
+
+} // namespace eos::common
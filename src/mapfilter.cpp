@@ -1,201 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "alloccounter.hpp"
+#include "policy.hpp"
+#include "policykeycache.hpp"
+#include "resolvedpolicy.hpp"
+#include "rcupolicystore.hpp"
+#include "versionedpolicy.hpp"
+#include "policyworkload.hpp"
+#include "policybatch.hpp"
 #include "benchmark/benchmark.h"
 
-namespace eos::common {
-  //----------------------------------------------------------------------------
-//! Transfer a container onto another, this variants destructively move values
-//! from other container onto source container at a given pos.
-//! \tparam C container type -  will be inferred
-//! \param c container where other container will be spliced onto
-//! \param other container whose elements will be consumed
-//! \param pos position where we need to splice
-//----------------------------------------------------------------------------
-template <typename C>
-void
-splice(C& c, C&& other,
-       typename C::const_iterator pos)
-{
-  c.insert(pos,
-           std::make_move_iterator(other.begin()),
-           std::make_move_iterator(other.end()));
-}
-
-//----------------------------------------------------------------------------
-//! Transfer a container onto another at the end, this variants destructively move values
-//! from other container onto source container at a given pos.
-//! \tparam C container type -  will be inferred
-//! \param c container where other container will be spliced onto
-//! \param other container whose elements will be consumed
-//----------------------------------------------------------------------------
-template <typename C>
-void splice(C& c, C&& other)
-{
-  splice(c, std::move(other), c.end());
-}
-
-//----------------------------------------------------------------------------
-//! erase_if that erases elements in place for elements matching a predicate
-//! This is useful in erase remove idiom useful for assoc. containers where
-//! std::remove_if will not compile, almost borrowed from erase_if C++ ref page
-//!
-//! @param C the associative container, elements will be removed in place
-//! @param pred the predicate to evaluate, please note the container
-//!             value_type aka the pair of values will be the input for the
-//!             predicate
-//! @return the no of elements removed
-//! Usage eg:
-//!   eos::common::erase_if(m, [](const auto& p){ return p.first % 2 == 0;})
-//----------------------------------------------------------------------------
-template <typename C, typename Pred>
-typename C::size_type
-erase_if(C& c, Pred pred)
-{
-  auto init_sz = c.size();
-  for (auto it = c.begin(), last = c.end(); it != last;) {
-    if (pred(*it)) {
-      it = c.erase(it);
-    } else {
-      ++it;
-    }
+static void BM_GetConfigKeys(benchmark::State& state) {
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    benchmark::DoNotOptimize(Policy::GetConfigKeys(".user:user1",
+                                                   ".group:group1",
+                                                   ".app:app1000",
+                                                   true,
+                                                   true));
   }
-  return init_sz - c.size();
 }
 
-
-} // namespace eos::common
-
-struct Policy {
-  static std::vector<std::string> GetConfigKeys(const std::string& user_key,
-                                                const std::string& group_key,
-                                                const std::string& app_key,
-                                                bool is_rw,
-                                                bool local=false);
-
-  static std::vector<std::string> GetRWConfigKeys(const std::string& key_name,
-                                                    const std::string& user_key,
-                                                    const std::string& group_key,
-                                                    const std::string& app_key);
-
-  static std::string GetRWValue(const std::map<std::string, std::string>& conf_map,
-                                const std::string& key_name,
-                                const std::string& user_key,
-                                const std::string& group_key,
-                                const std::string& app_key);
-
-  static std::string getRWkey(const std::string& key_name,
-                              bool is_rw,
-                              bool is_local=false);
-
-  static const std::vector<std::string> gBasePolicyKeys;
-  static const std::vector<std::string> gBasePolicyRWKeys;
-
-};
-
-const std::vector<std::string> Policy::gBasePolicyKeys = {
-  "policy.space",
-  "policy.layout",
-  "policy.nstripes",
-  "policy.checksum",
-  "policy.blockchecksum",
-  "policy.localredirect"
-};
-
-static std::string POLICY_BANDWIDTH="policy.bandwidth";
-static std::string POLICY_IOPRIORITY="policy.iopriority";
-static std::string POLICY_IOTYPE = "policy.iotype";
-static std::string POLICY_SCHEDULE="policy.schedule";
-const std::vector<std::string> Policy::gBasePolicyRWKeys = {
-  "policy.bandwidth",
-  "policy.iopriority",
-  "policy.iotype",
-  "policy.schedule"
-};
-
-
-std::vector<std::string>
-Policy::GetConfigKeys(const std::string& user_key,
-                      const std::string& group_key,
-                      const std::string& app_key,
-                      bool is_rw,
-                      bool local)
-{
-  std::string base_prefix;
-  std::vector<std::string> config_keys;
-  config_keys.reserve(22);
-  if (local) {
-    base_prefix = "local.";
-  }
-
-  // copy elements from base vector, with an optional prefix
-  std::transform(gBasePolicyKeys.cbegin(),
-                 gBasePolicyKeys.cend(),
-                 std::back_inserter(config_keys),
-                 [&base_prefix](const std::string& in) {
-                   return base_prefix + in;
-                 });
-
-
-  std::string rw_marker = is_rw ? ":w" : ":r";
-  for (const auto& _key: gBasePolicyRWKeys) {
-    eos::common::splice(config_keys,
-                        GetRWConfigKeys(getRWkey(_key, is_rw, local),
-                                        user_key, group_key, app_key));
+static void BM_GetConfigKeysTemplate(benchmark::State& state) {
+  eos::common::PolicyKeyTemplate tmpl(true, true);
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    benchmark::DoNotOptimize(tmpl.expand(".user:user1",
+                                         ".group:group1",
+                                         ".app:app1000"));
   }
-
-  return config_keys;
-}
-
-std::vector<std::string>
-Policy::GetRWConfigKeys(const std::string& key_name,
-                        const std::string& user_key,
-                        const std::string& group_key,
-                        const std::string& app_key)
-{
-
-  return {
-      key_name + app_key,
-      key_name + user_key,
-      key_name + group_key,
-      key_name
-  };
 }
 
-
-std::string
-Policy::GetRWValue(const std::map<std::string, std::string>& conf_map,
-                   const std::string& key_name,
-                   const std::string& user_key,
-                   const std::string& group_key,
-                   const std::string& app_key)
-{
-  for (const auto& k : GetRWConfigKeys(key_name, user_key, group_key, app_key)) {
-    if (const auto& kv = conf_map.find(k);
-        kv != conf_map.end() &&
-        !kv->second.empty()) {
-      return kv->second;
-    }
+static void BM_GetConfigKeysCachedWarm(benchmark::State& state) {
+  eos::common::PolicyKeyCache cache(1 << 20);
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    benchmark::DoNotOptimize(cache.get(".user:user1",
+                                       ".group:group1",
+                                       ".app:app1000",
+                                       true,
+                                       true));
   }
-  return {};
-}
-
-std::string
-Policy::getRWkey(const std::string& key_name, bool is_rw, bool is_local)
-{
-  std::string base_prefix = is_local ? "local." : "";
-  std::string rw_marker = is_rw ? ":w" : ":r";
-  return base_prefix + key_name + rw_marker;
 }
 
+// Identities cycle over range(0) distinct users, the cache budget only holds
+// a few hundred key sets so large ranges mostly miss
+static constexpr size_t kKeyCacheBudget = 1 << 19;
 
-static void BM_GetConfigKeys(benchmark::State& state) {
+static void BM_GetConfigKeysCycle(benchmark::State& state) {
+  int64_t i = 0;
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
-    benchmark::DoNotOptimize(Policy::GetConfigKeys(".user:user1",
-                                                   ".group:group1",
-                                                   ".app:app1000",
+    auto id = std::to_string(i++ % state.range(0));
+    benchmark::DoNotOptimize(Policy::GetConfigKeys(".user:user" + id,
+                                                   ".group:group" + id,
+                                                   ".app:app" + id,
                                                    true,
                                                    true));
   }
 }
 
+static void BM_GetConfigKeysCachedCycle(benchmark::State& state) {
+  eos::common::PolicyKeyCache cache(kKeyCacheBudget);
+  int64_t i = 0;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    auto id = std::to_string(i++ % state.range(0));
+    benchmark::DoNotOptimize(cache.get(".user:user" + id,
+                                       ".group:group" + id,
+                                       ".app:app" + id,
+                                       true,
+                                       true));
+  }
+  auto stats = cache.stats();
+  state.counters["hit_ratio"] = double(stats.hits) / (stats.hits + stats.misses);
+}
+
 struct UserParams {
   std::string user_key;
   std::string group_key;
@@ -208,6 +93,7 @@ static void BM_PopGetConfigValues(benchmark::State& state) {
   bool schedule;
   std::string iopriority, iotype, bandwidth;
   using namespace std::string_literals;
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     std::string user_key = ".user:user"s + std::to_string(state.range(0));
     std::string group_key = ".group:group"s + std::to_string(state.range(0));
@@ -236,12 +122,84 @@ static void BM_PopGetConfigValues(benchmark::State& state) {
 
 }
 
-static void BM_GetConfigValues(benchmark::State& state) {
+static void BM_PopGetConfigValuesCached(benchmark::State& state) {
+  eos::common::PolicyKeyCache cache(kKeyCacheBudget);
+  std::map <std::string, std::string> spacepolicies;
+  bool schedule;
+  std::string iopriority, iotype, bandwidth;
+  using namespace std::string_literals;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::string user_key = ".user:user"s + std::to_string(state.range(0));
+    std::string group_key = ".group:group"s + std::to_string(state.range(0));
+    std::string app_key = ".app:app"s + std::to_string(state.range(0));
+    bool rw=true;
+    bool is_local=true;
+    auto keys = cache.get(user_key, group_key, app_key, true, true);
+    for (const auto& k: keys->keys) {
+      benchmark::DoNotOptimize(spacepolicies.insert_or_assign(k,
+                                                              "dummy" + std::to_string(state.range(0))));
+    }
+
+    benchmark::DoNotOptimize(schedule = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_SCHEDULE, rw, is_local),
+                                                           user_key, group_key, app_key) == "1");
+    benchmark::DoNotOptimize(iopriority = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOPRIORITY, rw, is_local),
+                                                             user_key, group_key, app_key));
+    benchmark::DoNotOptimize(iotype = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOTYPE, rw, is_local),
+                                                         user_key, group_key, app_key));
+    benchmark::DoNotOptimize(bandwidth = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_BANDWIDTH, rw, is_local),
+                                                            user_key, group_key, app_key));
+  }
+}
+
+// As above but the identity cycles over range(0) users, with and without the
+// key cache; the policy map ends up with the keys of all range(0) users
+template <bool cached>
+static void BM_PopGetConfigValuesCycle(benchmark::State& state) {
+  eos::common::PolicyKeyCache cache(kKeyCacheBudget);
   std::map <std::string, std::string> spacepolicies;
   std::vector<std::string> keys;
   bool schedule;
   std::string iopriority, iotype, bandwidth;
   using namespace std::string_literals;
+  int64_t i = 0;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    auto id = std::to_string(i++ % state.range(0));
+    std::string user_key = ".user:user"s + id;
+    std::string group_key = ".group:group"s + id;
+    std::string app_key = ".app:app"s + id;
+    bool rw=true;
+    bool is_local=true;
+    eos::common::PolicyKeyCache::value_type cached_keys;
+    if constexpr (cached) {
+      cached_keys = cache.get(user_key, group_key, app_key, true, true);
+    } else {
+      keys = Policy::GetConfigKeys(user_key, group_key, app_key, true, true);
+    }
+
+    for (const auto& k: cached ? cached_keys->keys : keys) {
+      benchmark::DoNotOptimize(spacepolicies.insert_or_assign(k, "dummy" + id));
+    }
+
+    benchmark::DoNotOptimize(schedule = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_SCHEDULE, rw, is_local),
+                                                           user_key, group_key, app_key) == "1");
+    benchmark::DoNotOptimize(iopriority = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOPRIORITY, rw, is_local),
+                                                             user_key, group_key, app_key));
+    benchmark::DoNotOptimize(iotype = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOTYPE, rw, is_local),
+                                                         user_key, group_key, app_key));
+    benchmark::DoNotOptimize(bandwidth = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_BANDWIDTH, rw, is_local),
+                                                            user_key, group_key, app_key));
+  }
+}
+
+template <typename Map = std::map<std::string, std::string>>
+static void BM_GetConfigValues(benchmark::State& state) {
+  Map spacepolicies;
+  std::vector<std::string> keys;
+  bool schedule;
+  std::string iopriority, iotype, bandwidth;
+  using namespace std::string_literals;
   std::string user_key = ".user:user"s + std::to_string(state.range(0));
   std::string group_key = ".group:group"s + std::to_string(state.range(0));
   std::string app_key = ".app:app"s + std::to_string(state.range(0));
@@ -264,6 +222,7 @@ static void BM_GetConfigValues(benchmark::State& state) {
     }
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     benchmark::DoNotOptimize(schedule = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_SCHEDULE, rw, is_local),
                                                            user_key, group_key, app_key) == "1");
@@ -277,8 +236,9 @@ static void BM_GetConfigValues(benchmark::State& state) {
 
 }
 
+template <typename Map = std::map<std::string, std::string>>
 static void BM_GetConfigValuesErase(benchmark::State& state) {
-  std::map <std::string, std::string> spacepolicies;
+  Map spacepolicies;
   std::vector<std::string> keys;
   bool schedule;
   std::string iopriority, iotype, bandwidth;
@@ -305,6 +265,7 @@ static void BM_GetConfigValuesErase(benchmark::State& state) {
     }
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     eos::common::erase_if(spacepolicies, [](const auto& kv) {
       return kv.second.empty();
@@ -323,10 +284,540 @@ static void BM_GetConfigValuesErase(benchmark::State& state) {
 }
 
 
+// Same store as BM_GetConfigValues, all values resolved in a single call
+template <typename Map>
+static void BM_ResolvePolicy(benchmark::State& state) {
+  Map spacepolicies;
+  using namespace std::string_literals;
+  std::string user_key = ".user:user"s + std::to_string(state.range(0));
+  std::string group_key = ".group:group"s + std::to_string(state.range(0));
+  std::string app_key = ".app:app"s + std::to_string(state.range(0));
+  for (const auto& k: Policy::GetConfigKeys(user_key, group_key, app_key,
+                                            true, true)) {
+    if ((k.find(user_key) != std::string::npos) ||
+        (k.find(group_key) != std::string::npos) ||
+        (k.find(app_key) != std::string::npos)) {
+      spacepolicies.insert_or_assign(k,
+                                     "dummy" + std::to_string(state.range(0)));
+    } else {
+      spacepolicies.insert_or_assign(k, "");
+    }
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    auto resolved = eos::common::ResolvePolicy(spacepolicies, user_key,
+                                               group_key, app_key, true, true);
+    benchmark::DoNotOptimize(resolved.schedule() == "1");
+    benchmark::DoNotOptimize(resolved);
+  }
+}
+
+// The policy map holds the keys of range(0) identities, the lookups are for
+// the last one, shows how the lookup scales with the size of the map
+template <typename Map>
+static void BM_GetConfigValuesPopulated(benchmark::State& state) {
+  Map spacepolicies;
+  std::string iopriority, iotype, bandwidth;
+  using namespace std::string_literals;
+  std::string user_key, group_key, app_key;
+  bool rw=true;
+  bool is_local=true;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    user_key = ".user:user"s + std::to_string(i);
+    group_key = ".group:group"s + std::to_string(i);
+    app_key = ".app:app"s + std::to_string(i);
+    for (const auto& k: Policy::GetConfigKeys(user_key, group_key, app_key,
+                                              true, true)) {
+      spacepolicies.insert_or_assign(k, "dummy" + std::to_string(i));
+    }
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    benchmark::DoNotOptimize(iopriority = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOPRIORITY, rw, is_local),
+                                                             user_key, group_key, app_key));
+    benchmark::DoNotOptimize(iotype = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOTYPE, rw, is_local),
+                                                         user_key, group_key, app_key));
+    benchmark::DoNotOptimize(bandwidth = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_BANDWIDTH, rw, is_local),
+                                                            user_key, group_key, app_key));
+  }
+  state.counters["entries"] = spacepolicies.size();
+}
+
+// A policy map behind a lock, with the same read/update interface as
+// RcuPolicyStore, as a baseline for concurrent readers
+template <typename Mutex, typename Map = std::map<std::string, std::string>>
+class LockedPolicyStore {
+public:
+  template <typename F>
+  decltype(auto) read(F&& f) const {
+    if constexpr (std::is_same_v<Mutex, std::shared_mutex>) {
+      std::shared_lock lock(mtx);
+      return f(policies);
+    } else {
+      std::lock_guard lock(mtx);
+      return f(policies);
+    }
+  }
+
+  template <typename F>
+  void update(F&& f) {
+    std::lock_guard lock(mtx);
+    f(policies);
+  }
+
+  void insert_or_assign(std::string_view key, std::string_view value) {
+    std::lock_guard lock(mtx);
+    policies.insert_or_assign(std::string(key), std::string(value));
+  }
+
+private:
+  mutable Mutex mtx;
+  Map policies;
+};
+
+// Shared by the reader threads of one run, built in Setup so the reader
+// threads all start on a populated store; range(0) updates per second are
+// made by a background writer
+static constexpr int kConcurrentIdentities = 1000;
+template <typename Store>
+struct ConcurrentPolicyFixture {
+  static inline std::unique_ptr<Store> store;
+  static inline std::thread writer;
+  static inline std::atomic<bool> stop {false};
+
+  static void Setup(const benchmark::State& state) {
+    store = std::make_unique<Store>();
+    store->update([](auto& policies) {
+      for (int i = 0; i < kConcurrentIdentities; i++) {
+        auto id = std::to_string(i);
+        for (const auto& k: Policy::GetConfigKeys(".user:user" + id,
+                                                  ".group:group" + id,
+                                                  ".app:app" + id, true, true)) {
+          policies.insert_or_assign(k, "dummy" + id);
+        }
+      }
+    });
+
+    stop = false;
+    if (auto rate = state.range(0); rate > 0) {
+      writer = std::thread([rate] {
+        auto key = Policy::getRWkey(POLICY_IOPRIORITY, true, true) +
+                   ".user:user0";
+        for (int64_t n = 0; !stop; n++) {
+          store->insert_or_assign(key, std::to_string(n));
+          std::this_thread::sleep_for(std::chrono::microseconds(1000000 / rate));
+        }
+      });
+    }
+  }
+
+  static void Teardown(const benchmark::State&) {
+    stop = true;
+    if (writer.joinable()) {
+      writer.join();
+    }
+    store.reset();
+  }
+};
+
+template <typename Store>
+static void BM_ConcurrentGetRWValue(benchmark::State& state) {
+  using Fixture = ConcurrentPolicyFixture<Store>;
+  const auto& store = *Fixture::store;
+  auto id = std::to_string(state.thread_index() % kConcurrentIdentities);
+  std::string user_key = ".user:user" + id;
+  std::string group_key = ".group:group" + id;
+  std::string app_key = ".app:app" + id;
+  bool rw=true;
+  bool is_local=true;
+  std::string iopriority, iotype, bandwidth;
+  for (auto _: state) {
+    store.read([&](const auto& spacepolicies) {
+      benchmark::DoNotOptimize(iopriority = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOPRIORITY, rw, is_local),
+                                                               user_key, group_key, app_key));
+      benchmark::DoNotOptimize(iotype = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_IOTYPE, rw, is_local),
+                                                           user_key, group_key, app_key));
+      benchmark::DoNotOptimize(bandwidth = Policy::GetRWValue(spacepolicies, Policy::getRWkey(POLICY_BANDWIDTH, rw, is_local),
+                                                              user_key, group_key, app_key));
+    });
+  }
+}
+
+static void ConcurrentStoreArgs(benchmark::internal::Benchmark* b) {
+  b->ArgName("updates_per_s")->Arg(0)->Arg(1)->Arg(100)
+   ->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+   ->UseRealTime();
+}
+
+// Store with the keys of range(0) identities, with and without a value
+static void PopulateVersionedStore(eos::common::VersionedPolicyStore& store,
+                                   int64_t identities)
+{
+  store.update([&](auto& policies) {
+    for (int64_t i = 0; i < identities; i++) {
+      auto id = std::to_string(i);
+      for (const auto& k: Policy::GetConfigKeys(".user:user" + id,
+                                                ".group:group" + id,
+                                                ".app:app" + id, true, true)) {
+        policies.insert_or_assign(k, i % 2 ? "dummy" + id : "");
+      }
+    }
+  });
+}
+
+static void BM_ResolvedPolicyCacheHit(benchmark::State& state) {
+  eos::common::VersionedPolicyStore store;
+  PopulateVersionedStore(store, kConcurrentIdentities);
+  eos::common::ResolvedPolicyCache cache(store, 1 << 24);
+  for (auto _: state) {
+    auto p = cache.get(".user:user1", ".group:group1", ".app:app1", true, true);
+    benchmark::DoNotOptimize(p->view().schedule() == "1");
+  }
+}
+
+// The uncached equivalent of the above
+static void BM_ResolvedPolicyUncached(benchmark::State& state) {
+  eos::common::VersionedPolicyStore store;
+  PopulateVersionedStore(store, kConcurrentIdentities);
+  for (auto _: state) {
+    store.read([](const auto& policies) {
+      auto r = eos::common::ResolvePolicy(policies, ".user:user1",
+                                          ".group:group1", ".app:app1",
+                                          true, true);
+      benchmark::DoNotOptimize(r.schedule() == "1");
+    });
+  }
+}
+
+// A round of range(1) updates to user specific keys, followed by lookups of
+// all range(0) cached identities. Only the lookups are timed. Without
+// fine_grained the cache is dropped on every round, like a cache invalidated
+// by a single global version would be.
+template <bool fine_grained>
+static void BM_ResolvedPolicyCacheUpdateStorm(benchmark::State& state) {
+  eos::common::VersionedPolicyStore store;
+  auto identities = state.range(0);
+  PopulateVersionedStore(store, identities);
+  eos::common::ResolvedPolicyCache cache(store, 1 << 26);
+  std::vector<std::array<std::string, 3>> ids;
+  for (int64_t i = 0; i < identities; i++) {
+    auto id = std::to_string(i);
+    ids.push_back({".user:user" + id, ".group:group" + id, ".app:app" + id});
+    cache.get(ids[i][0], ids[i][1], ids[i][2], true, true);
+  }
+
+  auto initial_misses = cache.stats().cache.misses;
+  auto key = Policy::getRWkey(POLICY_IOPRIORITY, true, true);
+  int64_t round = 0;
+  for (auto _: state) {
+    state.PauseTiming();
+    store.update([&](auto& policies) {
+      for (int64_t i = 0; i < state.range(1); i++) {
+        policies.insert_or_assign(key + ids[(round + i) % identities][0],
+                                  std::to_string(round));
+      }
+    });
+    round++;
+    state.ResumeTiming();
+
+    if (!fine_grained) {
+      cache.clear();
+    }
+    for (const auto& id: ids) {
+      benchmark::DoNotOptimize(cache.get(id[0], id[1], id[2], true, true));
+    }
+  }
+
+  auto stats = cache.stats();
+  state.SetItemsProcessed(state.iterations() * identities);
+  state.counters["recomputed_per_round"] =
+    benchmark::Counter(stats.cache.misses - initial_misses,
+                       benchmark::Counter::kAvgIterations);
+}
+
+// VersionedPolicyStore with a ResolvedPolicyCache in front
+class CachedVersionedStore {
+public:
+  template <typename F>
+  void update(F&& f) {
+    store.update(std::forward<F>(f));
+  }
+
+  void insert_or_assign(std::string_view key, std::string_view value) {
+    store.insert_or_assign(key, value);
+  }
+
+  eos::common::ResolvedPolicyCache::value_type
+  resolve(const PolicyWorkload::Op& op) {
+    return cache.get(op.user_key, op.group_key, op.app_key, op.is_rw);
+  }
+
+private:
+  eos::common::VersionedPolicyStore store;
+  eos::common::ResolvedPolicyCache cache {store, 64 << 20};
+};
+
+template <typename Store>
+static void ResolveOp(Store& store, const PolicyWorkload::Op& op)
+{
+  if constexpr (std::is_same_v<Store, CachedVersionedStore>) {
+    benchmark::DoNotOptimize(store.resolve(op));
+  } else {
+    store.read([&](const auto& policies) {
+      auto r = eos::common::ResolvePolicy(policies, op.user_key, op.group_key,
+                                          op.app_key, op.is_rw);
+      benchmark::DoNotOptimize(r);
+    });
+  }
+}
+
+// A store populated for range(0) users, shared by the threads of one run
+template <typename Store>
+struct PolicyWorkloadFixture {
+  static inline std::unique_ptr<PolicyWorkload> workload;
+  static inline std::unique_ptr<Store> store;
+
+  static void Setup(const benchmark::State& state) {
+    PolicyWorkloadConfig cfg;
+    cfg.users = state.range(0);
+    cfg.write_ratio = state.range(1) / 1000.0;
+    workload = std::make_unique<PolicyWorkload>(cfg);
+    store = std::make_unique<Store>();
+    store->update([](auto& policies) {
+      workload->for_each_policy([&](const std::string& k, const std::string& v) {
+        policies.insert_or_assign(k, v);
+      });
+    });
+  }
+
+  static void Teardown(const benchmark::State&) {
+    store.reset();
+    workload.reset();
+  }
+};
+
+// Zipf distributed resolves, and range(1) per mille updates, of range(0)
+// users; reports the throughput and the per operation latency percentiles,
+// averaged over the threads. Only every kLatencyStride-th op is timed, into
+// a fixed ring of the latest samples, so that the clock reads stay out of
+// the throughput.
+template <typename Store>
+static void BM_PolicyWorkload(benchmark::State& state) {
+  constexpr uint64_t kLatencyStride = 64;
+  using Fixture = PolicyWorkloadFixture<Store>;
+  auto& store = *Fixture::store;
+  PolicyWorkload::Generator gen(*Fixture::workload, 1000 + state.thread_index());
+  auto run = [&store](const PolicyWorkload::Op& op) {
+    if (op.write) {
+      store.insert_or_assign(op.key, op.value);
+    } else {
+      ResolveOp(store, op);
+    }
+  };
+
+  std::vector<uint32_t> latencies(1 << 16);
+  uint64_t ops = 0;
+  size_t samples = 0;
+  for (auto _: state) {
+    const auto& op = gen.next();
+    if (ops++ % kLatencyStride) {
+      run(op);
+      continue;
+    }
+    auto start = std::chrono::steady_clock::now();
+    run(op);
+    latencies[samples++ % latencies.size()] =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  latencies.resize(std::min(samples, latencies.size()));
+
+  state.SetItemsProcessed(state.iterations());
+  auto percentile = [&](double p) {
+    auto it = latencies.begin() + size_t(p * (latencies.size() - 1));
+    std::nth_element(latencies.begin(), it, latencies.end());
+    return double(*it);
+  };
+  if (!latencies.empty()) {
+    state.counters["p50_ns"] = benchmark::Counter(percentile(0.50),
+                                                  benchmark::Counter::kAvgThreads);
+    state.counters["p99_ns"] = benchmark::Counter(percentile(0.99),
+                                                  benchmark::Counter::kAvgThreads);
+  }
+}
+
+static void PolicyWorkloadArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"users", "write_permille"})
+   ->ArgsProduct({benchmark::CreateRange(1000, 10000000, 10), {0, 1}})
+   ->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+   ->UseRealTime();
+}
+
+// Stores populated from a PolicyWorkload of the given number of users,
+// built once per process since the larger ones take a while
+template <typename Map>
+static const Map& WorkloadStore(const PolicyWorkload& workload)
+{
+  static std::map<uint64_t, std::unique_ptr<Map>> stores;
+  auto& store = stores[workload.config().users];
+  if (!store) {
+    store = std::make_unique<Map>();
+    workload.for_each_policy([&](const std::string& k, const std::string& v) {
+      store->insert_or_assign(k, v);
+    });
+  }
+  return *store;
+}
+
+// n queued read requests of a workload, in arrival order
+static std::vector<PolicyWorkload::Op> QueuedRequests(const PolicyWorkload& workload,
+                                                      size_t n)
+{
+  PolicyWorkload::Generator gen(workload, 7);
+  std::vector<PolicyWorkload::Op> ops;
+  while (ops.size() < n) {
+    if (const auto& op = gen.next(); !op.write) {
+      ops.push_back(op);
+    }
+  }
+  return ops;
+}
+
+// Resolving the queued requests one by one, either with the four
+// GetRWValue calls or ResolvePolicy
+template <typename Map, bool one_pass>
+static void BM_ResolvePerRequest(benchmark::State& state) {
+  PolicyWorkloadConfig cfg;
+  cfg.users = state.range(1);
+  PolicyWorkload workload(cfg);
+  const auto& store = WorkloadStore<Map>(workload);
+  auto ops = QueuedRequests(workload, state.range(0));
+  std::string iopriority, iotype, bandwidth, schedule;
+  for (auto _: state) {
+    for (const auto& op: ops) {
+      if constexpr (one_pass) {
+        auto r = eos::common::ResolvePolicy(store, op.user_key, op.group_key,
+                                            op.app_key, op.is_rw);
+        benchmark::DoNotOptimize(r);
+      } else {
+        benchmark::DoNotOptimize(schedule = Policy::GetRWValue(store, Policy::getRWkey(POLICY_SCHEDULE, op.is_rw),
+                                                               op.user_key, op.group_key, op.app_key));
+        benchmark::DoNotOptimize(iopriority = Policy::GetRWValue(store, Policy::getRWkey(POLICY_IOPRIORITY, op.is_rw),
+                                                                 op.user_key, op.group_key, op.app_key));
+        benchmark::DoNotOptimize(iotype = Policy::GetRWValue(store, Policy::getRWkey(POLICY_IOTYPE, op.is_rw),
+                                                             op.user_key, op.group_key, op.app_key));
+        benchmark::DoNotOptimize(bandwidth = Policy::GetRWValue(store, Policy::getRWkey(POLICY_BANDWIDTH, op.is_rw),
+                                                                op.user_key, op.group_key, op.app_key));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+template <typename Map>
+static void BM_ResolveBatch(benchmark::State& state) {
+  PolicyWorkloadConfig cfg;
+  cfg.users = state.range(1);
+  PolicyWorkload workload(cfg);
+  const auto& store = WorkloadStore<Map>(workload);
+  auto ops = QueuedRequests(workload, state.range(0));
+  eos::common::PolicyRequestBatch batch;
+  for (const auto& op: ops) {
+    batch.add(op.user_key, op.group_key, op.app_key, op.is_rw);
+  }
+
+  eos::common::PolicyBatchResolver resolver;
+  eos::common::ResolvedPolicyBatch resolved;
+  for (auto _: state) {
+    resolver.resolve(store, batch, resolved);
+    benchmark::DoNotOptimize(resolved);
+  }
+  state.SetItemsProcessed(state.iterations() * ops.size());
+}
+
+static void BatchArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch", "users"})
+   ->ArgsProduct({benchmark::CreateRange(1, 4096, 8), {100000, 10000000}});
+}
+
 
 BENCHMARK(BM_GetConfigKeys);
+BENCHMARK(BM_GetConfigKeysTemplate);
+BENCHMARK(BM_GetConfigKeysCachedWarm);
+BENCHMARK(BM_GetConfigKeysCycle)->RangeMultiplier(8)->Range(1,1<<15);
+BENCHMARK(BM_GetConfigKeysCachedCycle)->RangeMultiplier(8)->Range(1,1<<15);
 BENCHMARK(BM_PopGetConfigValues)->Range(1,1<<20);
-BENCHMARK(BM_GetConfigValues)->Range(1,1<<20);
-BENCHMARK(BM_GetConfigValuesErase)->Range(1,1<<20);
-
-BENCHMARK_MAIN();
+BENCHMARK(BM_PopGetConfigValuesCached)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_PopGetConfigValuesCycle, false)->RangeMultiplier(8)->Range(1,1<<12);
+BENCHMARK_TEMPLATE(BM_PopGetConfigValuesCycle, true)->RangeMultiplier(8)->Range(1,1<<12);
+BENCHMARK(BM_GetConfigValues<>)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValues, Policy::PolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValues, eos::common::FlatPolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValues, eos::common::SwissStringMap)->Range(1,1<<20);
+BENCHMARK(BM_GetConfigValuesErase<>)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesErase, Policy::PolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesErase, eos::common::FlatPolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesErase, eos::common::SwissStringMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_ResolvePolicy, std::map<std::string, std::string>)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_ResolvePolicy, Policy::PolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_ResolvePolicy, eos::common::FlatPolicyMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_ResolvePolicy, eos::common::SwissStringMap)->Range(1,1<<20);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesPopulated, std::map<std::string, std::string>)->Range(1,1<<14);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesPopulated, Policy::PolicyMap)->Range(1,1<<14);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesPopulated, eos::common::FlatPolicyMap)->Range(1,1<<14);
+BENCHMARK_TEMPLATE(BM_GetConfigValuesPopulated, eos::common::SwissStringMap)->Range(1,1<<14);
+BENCHMARK_TEMPLATE(BM_ConcurrentGetRWValue, LockedPolicyStore<std::mutex>)
+  ->Setup(ConcurrentPolicyFixture<LockedPolicyStore<std::mutex>>::Setup)
+  ->Teardown(ConcurrentPolicyFixture<LockedPolicyStore<std::mutex>>::Teardown)
+  ->Apply(ConcurrentStoreArgs);
+BENCHMARK_TEMPLATE(BM_ConcurrentGetRWValue, LockedPolicyStore<std::shared_mutex>)
+  ->Setup(ConcurrentPolicyFixture<LockedPolicyStore<std::shared_mutex>>::Setup)
+  ->Teardown(ConcurrentPolicyFixture<LockedPolicyStore<std::shared_mutex>>::Teardown)
+  ->Apply(ConcurrentStoreArgs);
+using SharedLockedFlatStore = LockedPolicyStore<std::shared_mutex, eos::common::FlatPolicyMap>;
+BENCHMARK_TEMPLATE(BM_ConcurrentGetRWValue, SharedLockedFlatStore)
+  ->Setup(ConcurrentPolicyFixture<SharedLockedFlatStore>::Setup)
+  ->Teardown(ConcurrentPolicyFixture<SharedLockedFlatStore>::Teardown)
+  ->Apply(ConcurrentStoreArgs);
+BENCHMARK_TEMPLATE(BM_ConcurrentGetRWValue, eos::common::RcuPolicyStore)
+  ->Setup(ConcurrentPolicyFixture<eos::common::RcuPolicyStore>::Setup)
+  ->Teardown(ConcurrentPolicyFixture<eos::common::RcuPolicyStore>::Teardown)
+  ->Apply(ConcurrentStoreArgs);
+BENCHMARK(BM_ResolvedPolicyCacheHit);
+BENCHMARK(BM_ResolvedPolicyUncached);
+BENCHMARK_TEMPLATE(BM_ResolvedPolicyCacheUpdateStorm, true)
+  ->ArgNames({"identities", "updates"})->ArgsProduct({{64, 512, 4096}, {1, 16}});
+BENCHMARK_TEMPLATE(BM_ResolvedPolicyCacheUpdateStorm, false)
+  ->ArgNames({"identities", "updates"})->ArgsProduct({{64, 512, 4096}, {1, 16}});
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, std::map<std::string, std::string>, false)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, std::map<std::string, std::string>, true)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolveBatch, std::map<std::string, std::string>)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, eos::common::FlatPolicyMap, false)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, eos::common::FlatPolicyMap, true)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolveBatch, eos::common::FlatPolicyMap)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, eos::common::SwissStringMap, false)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolvePerRequest, eos::common::SwissStringMap, true)->Apply(BatchArgs);
+BENCHMARK_TEMPLATE(BM_ResolveBatch, eos::common::SwissStringMap)->Apply(BatchArgs);
+
+#define POLICY_WORKLOAD_BENCHMARK(Store)                         \
+  BENCHMARK_TEMPLATE(BM_PolicyWorkload, Store)                   \
+    ->Setup(PolicyWorkloadFixture<Store>::Setup)                 \
+    ->Teardown(PolicyWorkloadFixture<Store>::Teardown)           \
+    ->Apply(PolicyWorkloadArgs)
+
+using MutexMapStore = LockedPolicyStore<std::mutex>;
+using SharedMapStore = LockedPolicyStore<std::shared_mutex>;
+using SharedPolicyMapStore = LockedPolicyStore<std::shared_mutex, Policy::PolicyMap>;
+using SharedSwissMapStore = LockedPolicyStore<std::shared_mutex, eos::common::SwissStringMap>;
+POLICY_WORKLOAD_BENCHMARK(MutexMapStore);
+POLICY_WORKLOAD_BENCHMARK(SharedMapStore);
+POLICY_WORKLOAD_BENCHMARK(SharedPolicyMapStore);
+POLICY_WORKLOAD_BENCHMARK(SharedSwissMapStore);
+POLICY_WORKLOAD_BENCHMARK(SharedLockedFlatStore);
+POLICY_WORKLOAD_BENCHMARK(eos::common::RcuPolicyStore);
+POLICY_WORKLOAD_BENCHMARK(eos::common::VersionedPolicyStore);
+POLICY_WORKLOAD_BENCHMARK(CachedVersionedStore);
+
+EOS_BENCHMARK_MAIN();
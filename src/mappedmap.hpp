@@ -0,0 +1,356 @@
+// ----------------------------------------------------------------------
+// File: mappedmap.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Immutable string to string map stored in a file that is mmap'ed and
+//! queried in place, so opening one costs a few system calls regardless of
+//! its size and pages are only read in as lookups touch them. Meant for
+//! maps that are rebuilt from scratch at every daemon restart.
+//!
+//! File layout, native endianness, every section 8 byte aligned:
+//!   Header
+//!   Entry[count]        key and value offsets into the arena, sorted by key
+//!   uint32_t[nslots]    optional linear probing hash index of entry
+//!                       numbers, nslots a power of 2 >= 2 * count
+//!   char[arena_size]    keys and values back to back
+//!
+//! Lookups go through the hash index when the file has one, otherwise they
+//! binary search the entries. Files are written by write(), to a temporary
+//! that is synced and renamed in place, so neither a reader nor a restart
+//! after a crash sees a partial file. Only the header is validated on open,
+//! the rest of the file is trusted.
+//----------------------------------------------------------------------------
+class MappedStringMap {
+public:
+  using value_type = std::pair<std::string_view, std::string_view>;
+
+  explicit MappedStringMap(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), "open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      auto err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "stat " + path);
+    }
+
+    length = st.st_size;
+    if (length < sizeof(Header)) {
+      ::close(fd);
+      throw std::runtime_error(path + ": not a mapped string map");
+    }
+
+    void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    auto err = errno;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      throw std::system_error(err, std::generic_category(), "mmap " + path);
+    }
+
+    base = static_cast<const char*>(p);
+    if (!load_header()) {
+      ::munmap(p, length);
+      throw std::runtime_error(path + ": not a mapped string map");
+    }
+  }
+
+  MappedStringMap(MappedStringMap&& other) noexcept {
+    swap(other);
+  }
+
+  MappedStringMap& operator=(MappedStringMap&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~MappedStringMap() {
+    if (base) {
+      ::munmap(const_cast<char*>(base), length);
+    }
+  }
+
+  void swap(MappedStringMap& other) noexcept {
+    std::swap(base, other.base);
+    std::swap(length, other.length);
+    std::swap(entries, other.entries);
+    std::swap(slots, other.slots);
+    std::swap(arena, other.arena);
+    std::swap(count, other.count);
+    std::swap(nslots, other.nslots);
+  }
+
+  std::optional<std::string_view> find(std::string_view key) const {
+    if (nslots) {
+      uint32_t mask = nslots - 1;
+      for (uint32_t i = hash(key) & mask;; i = (i + 1) & mask) {
+        auto idx = slots[i];
+        if (idx == kEmpty) {
+          return std::nullopt;
+        }
+        if (key_of(entries[idx]) == key) {
+          return value_of(entries[idx]);
+        }
+      }
+    }
+
+    auto e = std::lower_bound(entries, entries + count, key,
+                              [this](const Entry& e, std::string_view k) {
+                                return key_of(e) < k;
+                              });
+    if (e != entries + count && key_of(*e) == key) {
+      return value_of(*e);
+    }
+    return std::nullopt;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Call f(value_type) for every entry, in key order
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void for_each(F f) const {
+    for (uint64_t i = 0; i < count; i++) {
+      f(value_type(key_of(entries[i]), value_of(entries[i])));
+    }
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool has_hash_index() const { return nslots != 0; }
+
+  //--------------------------------------------------------------------------
+  //! Write the (key, value) pairs of kvs to path, e.g. a std::map or any
+  //! other range of pairs convertible to string views. Of duplicate keys the
+  //! first one is kept.
+  //!
+  //! @param hash_index whether to add the hash index, which costs 8 bytes
+  //!        or more per entry and saves the binary search
+  //--------------------------------------------------------------------------
+  template <typename Range>
+  static void write(const std::string& path, const Range& kvs,
+                    bool hash_index = true) {
+    std::vector<value_type> sorted;
+    for (const auto& kv: kvs) {
+      sorted.emplace_back(kv.first, kv.second);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const value_type& a, const value_type& b) {
+                       return a.first < b.first;
+                     });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                             [](const value_type& a, const value_type& b) {
+                               return a.first == b.first;
+                             }),
+                 sorted.end());
+    if (sorted.size() >= kEmpty) {
+      throw std::length_error("mapped string map: too many entries");
+    }
+
+    Header h {};
+    std::memcpy(h.magic, kMagic, sizeof(h.magic));
+    h.version = kVersion;
+    h.count = sorted.size();
+    h.entries_off = sizeof(Header);
+    h.slots_off = h.entries_off + h.count * sizeof(Entry);
+    h.nslots = 0;
+    if (hash_index) {
+      h.nslots = 16;
+      while (h.nslots < 2 * h.count) {
+        h.nslots *= 2;
+      }
+    }
+    h.arena_off = align(h.slots_off + h.nslots * sizeof(uint32_t));
+
+    std::vector<Entry> index;
+    index.reserve(sorted.size());
+    uint64_t arena_size = 0;
+    for (const auto& [k, v]: sorted) {
+      if (arena_size + k.size() + v.size() > UINT32_MAX) {
+        throw std::length_error("mapped string map: arena exceeds 4 GiB");
+      }
+      Entry e {static_cast<uint32_t>(arena_size), static_cast<uint32_t>(k.size()),
+               static_cast<uint32_t>(arena_size + k.size()),
+               static_cast<uint32_t>(v.size())};
+      arena_size += k.size() + v.size();
+      index.push_back(e);
+    }
+    h.arena_size = arena_size;
+
+    std::vector<uint32_t> table(h.nslots, kEmpty);
+    for (uint32_t idx = 0; idx < index.size() && h.nslots; idx++) {
+      uint64_t mask = h.nslots - 1;
+      auto i = hash(sorted[idx].first) & mask;
+      while (table[i] != kEmpty) {
+        i = (i + 1) & mask;
+      }
+      table[i] = idx;
+    }
+
+    auto tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+      throw std::system_error(errno, std::generic_category(), "open " + tmp);
+    }
+    // fwrite wants a non null buffer even for empty writes
+    auto put = [f](const void* p, size_t n) {
+      return n == 0 || std::fwrite(p, 1, n, f) == n;
+    };
+    static const char pad[8] = {};
+    bool ok = put(&h, sizeof(h)) &&
+              put(index.data(), index.size() * sizeof(Entry)) &&
+              put(table.data(), table.size() * sizeof(uint32_t)) &&
+              put(pad, h.arena_off - (h.slots_off + h.nslots * sizeof(uint32_t)));
+    for (auto it = sorted.begin(); ok && it != sorted.end(); ++it) {
+      ok = put(it->first.data(), it->first.size()) &&
+           put(it->second.data(), it->second.size());
+    }
+    // the data has to be on disk before the rename can be
+    ok = ok && std::fflush(f) == 0 && ::fsync(fileno(f)) == 0;
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+      auto err = errno;
+      std::remove(tmp.c_str());
+      throw std::system_error(err, std::generic_category(), "write " + path);
+    }
+    sync_dir(path);
+  }
+
+  //--------------------------------------------------------------------------
+  //! 64 bit FNV-1a of the key, folded; part of the file format
+  //--------------------------------------------------------------------------
+  static uint64_t hash(std::string_view key) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : key) {
+      h = (h ^ c) * 1099511628211ull;
+    }
+    return h ^ (h >> 32);
+  }
+
+private:
+  static constexpr char kMagic[8] = {'E', 'O', 'S', 'S', 'M', 'A', 'P', '\0'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kEmpty = UINT32_MAX;
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t entries_off;
+    uint64_t slots_off;
+    uint64_t nslots;
+    uint64_t arena_off;
+    uint64_t arena_size;
+  };
+
+  struct Entry {
+    uint32_t key_off;
+    uint32_t key_len;
+    uint32_t val_off;
+    uint32_t val_len;
+  };
+
+  static uint64_t align(uint64_t off) {
+    return (off + 7) & ~uint64_t(7);
+  }
+
+  // fsync the directory holding path, which makes a rename into it durable
+  static void sync_dir(const std::string& path) {
+    auto slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." :
+                      slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::fsync(fd) != 0) {
+      auto err = errno;
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      throw std::system_error(err, std::generic_category(), "sync " + dir);
+    }
+    ::close(fd);
+  }
+
+  // check that the sections lie within the file and point at them
+  bool load_header() {
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+        h.version != kVersion || h.count >= kEmpty ||
+        (h.nslots & (h.nslots - 1)) != 0 || h.nslots > UINT32_MAX ||
+        (h.nslots && h.nslots < 2 * h.count) ||
+        h.entries_off != sizeof(Header) ||
+        h.slots_off != h.entries_off + h.count * sizeof(Entry) ||
+        h.arena_off < h.slots_off + h.nslots * sizeof(uint32_t) ||
+        h.arena_off > length || h.arena_size > length - h.arena_off) {
+      return false;
+    }
+
+    count = h.count;
+    nslots = h.nslots;
+    entries = reinterpret_cast<const Entry*>(base + h.entries_off);
+    slots = reinterpret_cast<const uint32_t*>(base + h.slots_off);
+    arena = base + h.arena_off;
+    return true;
+  }
+
+  std::string_view key_of(const Entry& e) const {
+    return {arena + e.key_off, e.key_len};
+  }
+
+  std::string_view value_of(const Entry& e) const {
+    return {arena + e.val_off, e.val_len};
+  }
+
+  const char* base {nullptr};
+  size_t length {0};
+  const Entry* entries {nullptr};
+  const uint32_t* slots {nullptr};
+  const char* arena {nullptr};
+  uint64_t count {0};
+  uint64_t nslots {0};
+};
+
+} // namespace eos::common
@@ -0,0 +1,160 @@
+#include "XrdOucString.hh"
+#include "opaque.hpp"
+#include <string>
+#include <vector>
+#include "benchmark/benchmark.h"
+
+// An opaque string shaped like what the MGM sees, a few well known keys
+// followed by filler pairs, every 4th value carries an escaped '/'
+static std::string MakeOpaque(size_t npairs)
+{
+  std::string s = "eos.app=fuse&eos.ruid=0&mgm.path=%2Feos%2Fuser%2Ffile";
+  for (size_t i = 3; i < npairs; i++) {
+    s += "&key" + std::to_string(i) + "=";
+    s += (i % 4 == 0) ? "dir%2Fval" : "val";
+    s += std::to_string(i);
+  }
+  return s;
+}
+
+// keys probed by the lookup benchmarks, the last one misses
+static const char* kLookupKeys[] = {"eos.app", "eos.ruid", "mgm.path",
+                                    "key3", "eos.rgid"};
+
+// XrdOucEnv style parse: tokenize on '&', then cut every token at '='
+static void XrdParseOpaque(XrdOucString& env,
+                           std::vector<std::pair<XrdOucString, XrdOucString>>& kvs)
+{
+  XrdOucString tok;
+  int from = 0;
+  kvs.clear();
+  while ((from = env.tokenize(tok, from, '&')) != -1) {
+    if (!tok.length()) {
+      continue;
+    }
+    int eq = tok.find('=');
+    if (eq == STR_NPOS) {
+      kvs.emplace_back(tok, XrdOucString());
+    } else {
+      kvs.emplace_back(XrdOucString(tok, 0, eq - 1),
+                       XrdOucString(tok, eq + 1));
+    }
+  }
+}
+
+static std::vector<std::pair<std::string, std::string>>
+StdParseOpaque(const std::string& opaque)
+{
+  std::vector<std::pair<std::string, std::string>> kvs;
+  size_t start = 0;
+  while (start < opaque.size()) {
+    auto end = opaque.find('&', start);
+    if (end == std::string::npos) {
+      end = opaque.size();
+    }
+    if (end != start) {
+      auto tok = opaque.substr(start, end - start);
+      auto eq = tok.find('=');
+      if (eq == std::string::npos) {
+        kvs.emplace_back(std::move(tok), std::string());
+      } else {
+        kvs.emplace_back(tok.substr(0, eq), tok.substr(eq + 1));
+      }
+    }
+    start = end + 1;
+  }
+  return kvs;
+}
+
+static void BM_XrdTokenizeParse(benchmark::State& state) {
+  XrdOucString env(MakeOpaque(state.range(0)).c_str());
+  std::vector<std::pair<XrdOucString, XrdOucString>> kvs;
+  for (auto _: state) {
+    XrdParseOpaque(env, kvs);
+    benchmark::DoNotOptimize(kvs.data());
+  }
+}
+
+static void BM_StdStringParse(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    benchmark::DoNotOptimize(StdParseOpaque(opaque));
+  }
+}
+
+static void BM_OpaqueParse(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    for (const auto& kv: eos::common::OpaqueParser(opaque)) {
+      benchmark::DoNotOptimize(kv);
+    }
+  }
+}
+
+static void BM_XrdTokenizeLookup(benchmark::State& state) {
+  XrdOucString env(MakeOpaque(state.range(0)).c_str());
+  std::vector<std::pair<XrdOucString, XrdOucString>> kvs;
+  for (auto _: state) {
+    XrdParseOpaque(env, kvs);
+    for (const char* key: kLookupKeys) {
+      for (auto& kv: kvs) {
+        if (kv.first == key) {
+          benchmark::DoNotOptimize(kv.second.c_str());
+          break;
+        }
+      }
+    }
+  }
+}
+
+static void BM_OpaqueLinearLookup(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    eos::common::OpaqueParser parser(opaque);
+    for (const char* key: kLookupKeys) {
+      benchmark::DoNotOptimize(parser.find(key));
+    }
+  }
+}
+
+static void BM_OpaqueIndexLookup(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    eos::common::OpaqueIndex<> index(opaque);
+    for (const char* key: kLookupKeys) {
+      benchmark::DoNotOptimize(index.find(key));
+    }
+  }
+}
+
+// Decode every value, the lazy variant only pays for the escaped ones
+static void BM_StdStringDecodeAll(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    for (auto& kv: StdParseOpaque(opaque)) {
+      std::string out;
+      eos::common::PercentDecode(kv.second, out);
+      benchmark::DoNotOptimize(out);
+    }
+  }
+}
+
+static void BM_OpaqueDecodeAll(benchmark::State& state) {
+  std::string opaque = MakeOpaque(state.range(0));
+  for (auto _: state) {
+    for (const auto& kv: eos::common::OpaqueParser(opaque)) {
+      benchmark::DoNotOptimize(kv.decoded_value());
+    }
+  }
+}
+
+BENCHMARK(BM_XrdTokenizeParse)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_StdStringParse)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_OpaqueParse)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_XrdTokenizeLookup)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_OpaqueLinearLookup)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_OpaqueIndexLookup)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_StdStringDecodeAll)->RangeMultiplier(2)->Range(4,64);
+BENCHMARK(BM_OpaqueDecodeAll)->RangeMultiplier(2)->Range(4,64);
+
+BENCHMARK_MAIN();
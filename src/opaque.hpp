@@ -0,0 +1,294 @@
+// ----------------------------------------------------------------------
+// File: opaque.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "lazysplit.hpp"
+
+namespace eos::common {
+namespace detail {
+
+inline int hexval(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+inline uint32_t fnv1a(std::string_view s)
+{
+  uint32_t h = 2166136261u;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+} // detail
+
+//----------------------------------------------------------------------------
+//! Percent-decode a string, ie. %2F -> '/'. Malformed escape sequences are
+//! copied verbatim, '+' is not treated specially.
+//!
+//! @param in the encoded input
+//! @param out string to append the decoded output to
+//----------------------------------------------------------------------------
+inline void PercentDecode(std::string_view in, std::string& out)
+{
+  out.reserve(out.size() + in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (in[i] == '%' && i + 2 < in.size()) {
+      int hi = detail::hexval(in[i+1]);
+      int lo = detail::hexval(in[i+2]);
+      if (hi >= 0 && lo >= 0) {
+        out.push_back(static_cast<char>((hi << 4) | lo));
+        i += 2;
+        continue;
+      }
+    }
+    out.push_back(in[i]);
+  }
+}
+
+//----------------------------------------------------------------------------
+//! A single key=value pair of an opaque string, both members are views into
+//! the original opaque buffer. The value is stored in its raw form and is only
+//! decoded when asked for.
+//----------------------------------------------------------------------------
+struct OpaqueKV {
+  std::string_view key;
+  std::string_view value;
+
+  bool is_encoded() const {
+    return value.find('%') != std::string_view::npos;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Decoded value, this only allocates when the value has escape sequences
+  //! or exceeds the SSO buffer.
+  //--------------------------------------------------------------------------
+  std::string decoded_value() const {
+    if (!is_encoded()) {
+      return std::string(value);
+    }
+    std::string out;
+    PercentDecode(value, out);
+    return out;
+  }
+
+  static OpaqueKV from_token(std::string_view token) {
+    auto pos = token.find('=');
+    if (pos == std::string_view::npos) {
+      return {token, {}};
+    }
+    return {token.substr(0, pos), token.substr(pos + 1)};
+  }
+};
+
+//----------------------------------------------------------------------------
+//! Lazy, zero-copy parser for opaque/query strings of the form
+//! k1=v1&k2=v2&... Iterating yields OpaqueKV views, nothing is copied or
+//! decoded until explicitly requested. Empty tokens (&&) are skipped, a token
+//! without '=' yields a key with an empty value. For repeated lookups over the
+//! same opaque string see OpaqueIndex.
+//!
+//! Usage eg:
+//!   for (auto kv: OpaqueParser("eos.app=foo&eos.ruid=0")) { ... }
+//----------------------------------------------------------------------------
+class OpaqueParser {
+public:
+  using split_type = LazySplit<std::string_view, char>;
+
+  OpaqueParser(std::string_view opaque, char delim = '&') :
+    tokens(opaque, delim) {}
+
+  class iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = OpaqueKV;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const OpaqueKV*;
+    using reference = const OpaqueKV&;
+
+    iterator(split_type::iterator it, split_type::iterator end) :
+      it(it), end(end) { update(); }
+
+    iterator& operator++() {
+      ++it;
+      update();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator curr = *this;
+      ++(*this);
+      return curr;
+    }
+
+    reference operator*() const { return kv; }
+    pointer operator->() const { return &kv; }
+
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.it == b.it;
+    }
+
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return !(a==b);
+    }
+
+  private:
+    void update() {
+      if (it != end) {
+        kv = OpaqueKV::from_token(*it);
+      }
+    }
+
+    split_type::iterator it;
+    split_type::iterator end;
+    OpaqueKV kv;
+  };
+
+  iterator begin() const { return {tokens.begin(), tokens.end()}; }
+  iterator end() const { return {tokens.end(), tokens.end()}; }
+
+  //--------------------------------------------------------------------------
+  //! Linear lookup of a key, the first occurrence wins
+  //--------------------------------------------------------------------------
+  std::optional<std::string_view> find(std::string_view key) const {
+    for (const auto& kv: *this) {
+      if (kv.key == key) {
+        return kv.value;
+      }
+    }
+    return std::nullopt;
+  }
+
+private:
+  split_type tokens;
+};
+
+//----------------------------------------------------------------------------
+//! O(1) lookup index over an opaque string. The pairs and a small open
+//! addressing table of their key hashes are held inline, so building the index
+//! does no allocations. Pairs beyond Capacity are not indexed and are searched
+//! linearly in the remaining tail of the opaque string, first occurrence of a
+//! key wins in both cases.
+//!
+//! @tparam Capacity number of pairs that are indexed inline
+//----------------------------------------------------------------------------
+template <size_t Capacity = 64>
+class OpaqueIndex {
+  static_assert(Capacity > 0 && Capacity < 255, "Capacity must fit a uint8_t");
+  // keep the load factor at or below 0.5
+  static constexpr size_t kSlots = [] {
+    size_t n = 1;
+    while (n < 2 * Capacity) n <<= 1;
+    return n;
+  }();
+  static constexpr uint8_t kEmpty = 0xff;
+
+public:
+  OpaqueIndex(std::string_view opaque, char delim = '&') : delim(delim) {
+    slots.fill(kEmpty);
+    size_t start = 0;
+    while (start < opaque.size()) {
+      auto end = opaque.find(delim, start);
+      if (end == std::string_view::npos) {
+        end = opaque.size();
+      }
+
+      if (end != start) {
+        if (nentries == Capacity) {
+          tail = opaque.substr(start);
+          break;
+        }
+        insert(OpaqueKV::from_token(opaque.substr(start, end - start)));
+      }
+      start = end + 1;
+    }
+  }
+
+  std::optional<std::string_view> find(std::string_view key) const {
+    auto h = detail::fnv1a(key);
+    for (size_t i = h & (kSlots - 1);; i = (i + 1) & (kSlots - 1)) {
+      auto idx = slots[i];
+      if (idx == kEmpty) {
+        break;
+      }
+      if (hashes[idx] == h && entries[idx].key == key) {
+        return entries[idx].value;
+      }
+    }
+
+    if (!tail.empty()) {
+      return OpaqueParser(tail, delim).find(key);
+    }
+    return std::nullopt;
+  }
+
+  bool contains(std::string_view key) const {
+    return find(key).has_value();
+  }
+
+  const OpaqueKV* begin() const { return entries.data(); }
+  const OpaqueKV* end() const { return entries.data() + nentries; }
+  size_t size() const { return nentries; }
+  bool overflowed() const { return !tail.empty(); }
+
+private:
+  void insert(OpaqueKV kv) {
+    auto h = detail::fnv1a(kv.key);
+    size_t i = h & (kSlots - 1);
+    for (; slots[i] != kEmpty; i = (i + 1) & (kSlots - 1)) {
+      auto idx = slots[i];
+      if (hashes[idx] == h && entries[idx].key == kv.key) {
+        return;
+      }
+    }
+    slots[i] = static_cast<uint8_t>(nentries);
+    hashes[nentries] = h;
+    entries[nentries++] = kv;
+  }
+
+  std::array<OpaqueKV, Capacity> entries;
+  std::array<uint32_t, Capacity> hashes;
+  std::array<uint8_t, kSlots> slots;
+  size_t nentries {0};
+  std::string_view tail;
+  char delim;
+};
+
+} // namespace eos::common
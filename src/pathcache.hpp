@@ -0,0 +1,82 @@
+// ----------------------------------------------------------------------
+// File: pathcache.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lazysplit.hpp"
+#include "lrucache.hpp"
+#include "pathnormalize.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! A normalized path and its components, the components are views into the
+//! path member. Immutable once built, so it can be shared between threads.
+//----------------------------------------------------------------------------
+class NormalizedPath {
+public:
+  explicit NormalizedPath(std::string_view raw) : path(raw) {
+    NormalizePath(path);
+    for (auto c: LazySplit<std::string_view, char>(path, '/')) {
+      components.push_back(c);
+    }
+  }
+
+  // the components point into path, moving it could invalidate them
+  NormalizedPath(const NormalizedPath&) = delete;
+  NormalizedPath& operator=(const NormalizedPath&) = delete;
+
+  const std::string& str() const { return path; }
+  const std::vector<std::string_view>& parts() const { return components; }
+
+  size_t footprint() const {
+    return sizeof(*this) + path.capacity() +
+           components.capacity() * sizeof(std::string_view);
+  }
+
+private:
+  std::string path;
+  std::vector<std::string_view> components;
+};
+
+//----------------------------------------------------------------------------
+//! Bounded LRU cache of normalized, split paths keyed by the raw path, see
+//! ShardedLruCache for the sharding and budget. Misses normalize outside of
+//! the shard lock.
+//----------------------------------------------------------------------------
+class PathCache : public ShardedLruCache<NormalizedPath> {
+public:
+  using ShardedLruCache::ShardedLruCache;
+
+  value_type get(std::string_view raw) {
+    return get_or_create(raw, [](std::string_view key) {
+      return std::make_shared<const NormalizedPath>(key);
+    });
+  }
+};
+
+} // namespace eos::common
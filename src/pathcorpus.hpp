@@ -0,0 +1,148 @@
+// ----------------------------------------------------------------------
+// File: pathcorpus.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+//! Knobs for the synthetic path corpus, the defaults roughly follow what a
+//! user area of a namespace looks like
+//----------------------------------------------------------------------------
+struct PathCorpusConfig {
+  size_t count {4096};
+  // number of components, uniform in [min_depth, max_depth]
+  size_t min_depth {2};
+  size_t max_depth {12};
+  // distinct names available at every depth, lower means more reuse
+  size_t fanout {64};
+  // name lengths are log-normal around the median, clamped to [1, max]
+  double name_len_median {8};
+  double name_len_sigma {0.7};
+  size_t name_len_max {200};
+  // fraction of paths with '//', '/./', 'x/../' detours or a trailing '/'
+  double dirty_ratio {0.0};
+  // fraction of names carrying multi-byte UTF-8 characters
+  double utf8_ratio {0.0};
+  uint64_t seed {42};
+};
+
+namespace detail {
+
+inline std::string MakeCorpusName(std::mt19937_64& gen,
+                                  const PathCorpusConfig& cfg)
+{
+  static const char ascii[] = "abcdefghijklmnopqrstuvwxyz0123456789._-";
+  static const char* utf8[] = {"é", "ü", "ß", "ø", "λ", "Ж", "日本", "データ",
+                               "ファイル", "😀"};
+  std::lognormal_distribution<double> len_dist(std::log(cfg.name_len_median),
+                                               cfg.name_len_sigma);
+  std::bernoulli_distribution use_utf8(cfg.utf8_ratio);
+  size_t len = std::clamp<size_t>(std::lround(len_dist(gen)), 1,
+                                  cfg.name_len_max);
+  bool has_utf8 = use_utf8(gen);
+  std::string name;
+  while (name.size() < len) {
+    if (has_utf8 && gen() % 4 == 0) {
+      name += utf8[gen() % (sizeof(utf8) / sizeof(utf8[0]))];
+    } else {
+      name += ascii[gen() % (sizeof(ascii) - 1)];
+    }
+  }
+
+  // '.' and '..' are not names
+  if (name == "." || name == "..") {
+    name += '_';
+  }
+  return name;
+}
+
+} // namespace detail
+
+//----------------------------------------------------------------------------
+//! Generate a reproducible corpus of absolute paths
+//----------------------------------------------------------------------------
+inline std::vector<std::string> GeneratePathCorpus(const PathCorpusConfig& cfg)
+{
+  std::mt19937_64 gen(cfg.seed);
+  // a pool of names per depth, so that paths share components
+  std::vector<std::vector<std::string>> names(cfg.max_depth);
+  for (auto& level: names) {
+    for (size_t i = 0; i < cfg.fanout; i++) {
+      level.push_back(detail::MakeCorpusName(gen, cfg));
+    }
+  }
+
+  std::uniform_int_distribution<size_t> depth_dist(cfg.min_depth,
+                                                   cfg.max_depth);
+  std::bernoulli_distribution dirty(cfg.dirty_ratio);
+  std::vector<std::string> paths;
+  paths.reserve(cfg.count);
+  for (size_t i = 0; i < cfg.count; i++) {
+    auto depth = depth_dist(gen);
+    bool is_dirty = dirty(gen);
+    std::string p;
+    for (size_t d = 0; d < depth; d++) {
+      p += '/';
+      if (is_dirty) {
+        switch (gen() % 4) {
+        case 0: p += '/'; break;
+        case 1: p += "./"; break;
+        case 2: p += names[d][gen() % cfg.fanout] + "/../"; break;
+        default: break;
+        }
+      }
+      p += names[d][gen() % cfg.fanout];
+    }
+
+    if (is_dirty && gen() % 2) {
+      p += '/';
+    }
+    paths.emplace_back(p.empty() ? "/" : std::move(p));
+  }
+  return paths;
+}
+
+//----------------------------------------------------------------------------
+//! Load a path list, one path per line, empty lines are skipped
+//----------------------------------------------------------------------------
+inline std::vector<std::string> LoadPathCorpus(const std::string& filename)
+{
+  std::vector<std::string> paths;
+  std::ifstream in(filename);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      paths.emplace_back(std::move(line));
+    }
+  }
+  return paths;
+}
@@ -0,0 +1,148 @@
+// ----------------------------------------------------------------------
+// File: pathnormalize.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Check whether a path is already in the canonical form produced by
+//! NormalizePath, ie. absolute, no empty, '.' or '..' components and no
+//! trailing '/' unless the path is the root itself.
+//----------------------------------------------------------------------------
+inline bool IsCanonicalPath(std::string_view path)
+{
+  if (path.empty() || path[0] != '/') {
+    return false;
+  }
+
+  if (path.size() == 1) {
+    return true;
+  }
+
+  size_t start = 1;
+  while (true) {
+    auto end = path.find('/', start);
+    if (end == std::string_view::npos) {
+      end = path.size();
+    }
+
+    auto len = end - start;
+    // covers '//' and a trailing '/'
+    if (len == 0) {
+      return false;
+    }
+
+    if (path[start] == '.' &&
+        (len == 1 || (len == 2 && path[start + 1] == '.'))) {
+      return false;
+    }
+
+    if (end == path.size()) {
+      return true;
+    }
+    start = end + 1;
+  }
+}
+
+//----------------------------------------------------------------------------
+//! Normalize a path in place resolving all '//', '/./' and '/../' entries in a
+//! single forward pass. Produces the same result as PathProcessor::absPath:
+//! relative paths are made absolute, '..' above the root is dropped and an
+//! empty result yields "/". Nothing is allocated unless the input is relative.
+//!
+//! The write cursor never overtakes the read cursor, so components are
+//! compacted within the same buffer; the offsets of the last kMaxDepth
+//! components are kept in a stack so that '..' can rewind in O(1), deeper
+//! paths fall back to scanning back for the previous '/'.
+//----------------------------------------------------------------------------
+inline void NormalizePath(std::string& path)
+{
+  if (IsCanonicalPath(path)) {
+    return;
+  }
+
+  if (path.empty() || path[0] != '/') {
+    path.insert(path.begin(), '/');
+  }
+
+  constexpr size_t kMaxDepth = 64;
+  std::array<uint32_t, kMaxDepth> offsets;
+  size_t depth = 0;
+  char* p = path.data();
+  const size_t n = path.size();
+  size_t r = 0, w = 0;
+
+  while (r < n) {
+    while (r < n && p[r] == '/') {
+      ++r;
+    }
+
+    if (r == n) {
+      break;
+    }
+
+    size_t start = r;
+    while (r < n && p[r] != '/') {
+      ++r;
+    }
+
+    size_t len = r - start;
+    if (p[start] == '.') {
+      if (len == 1) {
+        continue;
+      }
+
+      if (len == 2 && p[start + 1] == '.') {
+        if (depth) {
+          --depth;
+          w = (depth < kMaxDepth) ? offsets[depth] :
+              std::string_view(p, w).rfind('/');
+        }
+        continue;
+      }
+    }
+
+    if (depth < kMaxDepth) {
+      offsets[depth] = w;
+    }
+    ++depth;
+    p[w++] = '/';
+    std::memmove(p + w, p + start, len);
+    w += len;
+  }
+
+  if (w == 0) {
+    p[w++] = '/';
+  }
+
+  path.resize(w);
+}
+
+} // namespace eos::common
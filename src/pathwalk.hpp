@@ -0,0 +1,204 @@
+// ----------------------------------------------------------------------
+// File: pathwalk.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "lazysplit.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Append only storage for path components. Bytes are copied once into fixed
+//! blocks and never move, so the component views handed out stay valid for
+//! the lifetime of the arena. The first block is inline so that walking a
+//! typical path only allocates the arena itself.
+//----------------------------------------------------------------------------
+class PathArena {
+public:
+  static constexpr size_t kBlockSize = 4096;
+  static constexpr size_t kInlineSize = 512;
+
+  PathArena() {
+    components.reserve(32);
+  }
+
+  PathArena(const PathArena&) = delete;
+  PathArena& operator=(const PathArena&) = delete;
+
+  //--------------------------------------------------------------------------
+  //! Split a path on '/' and append its components
+  //!
+  //! @return the index range [begin, end) of the new components
+  //--------------------------------------------------------------------------
+  std::pair<uint32_t, uint32_t> append(std::string_view path) {
+    uint32_t begin = components.size();
+    for (auto c: LazySplit<std::string_view, char>(store(path), '/')) {
+      components.push_back(c);
+    }
+    return {begin, static_cast<uint32_t>(components.size())};
+  }
+
+  std::string_view operator[](uint32_t idx) const {
+    return components[idx];
+  }
+
+private:
+  std::string_view store(std::string_view s) {
+    if (s.size() > cap - used) {
+      auto sz = std::max(kBlockSize, s.size());
+      blocks.emplace_back(new char[sz]);
+      cur = blocks.back().get();
+      cap = sz;
+      used = 0;
+    }
+    char* dst = cur + used;
+    std::memcpy(dst, s.data(), s.size());
+    used += s.size();
+    return {dst, s.size()};
+  }
+
+  std::array<char, kInlineSize> inline_block;
+  char* cur {inline_block.data()};
+  size_t cap {kInlineSize};
+  size_t used {0};
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::vector<std::string_view> components;
+};
+
+//----------------------------------------------------------------------------
+//! A queue of path components for walking a namespace path, a drop in for the
+//! std::deque<std::string> filled by PathProcessor::insertChunksIntoDeque.
+//!
+//! Components are views into a PathArena shared by all copies of a walk, the
+//! walk itself is a stack of index ranges into that arena. Prepending a whole
+//! split path (eg. a symlink target) pushes a single range, and copying a walk
+//! to snapshot it only copies the ranges, no component is ever copied again
+//! after it has been split. The arena only grows, so it should be scoped to a
+//! single lookup.
+//----------------------------------------------------------------------------
+class PathWalk {
+  struct Segment {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+public:
+  PathWalk() = default;
+
+  explicit PathWalk(std::string_view path) {
+    push_front(path);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Split a path and prepend all of its components
+  //--------------------------------------------------------------------------
+  void push_front(std::string_view path) {
+    if (!arena) {
+      arena = std::make_shared<PathArena>();
+    }
+
+    auto [begin, end] = arena->append(path);
+    if (begin != end) {
+      segments.push_back({begin, end});
+      count += end - begin;
+    }
+  }
+
+  std::string_view front() const {
+    return (*arena)[segments.back().begin];
+  }
+
+  void pop_front() {
+    auto& seg = segments.back();
+    if (++seg.begin == seg.end) {
+      segments.pop_back();
+    }
+    --count;
+  }
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    const_iterator(const PathWalk* w, size_t seg) : walk(w), seg(seg) {
+      if (seg) {
+        idx = walk->segments[seg - 1].begin;
+      }
+    }
+
+    reference operator*() const { return (*walk->arena)[idx]; }
+
+    const_iterator& operator++() {
+      if (++idx == walk->segments[seg - 1].end && --seg) {
+        idx = walk->segments[seg - 1].begin;
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator curr = *this;
+      ++(*this);
+      return curr;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.seg == b.seg && (a.seg == 0 || a.idx == b.idx);
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+      return !(a==b);
+    }
+
+  private:
+    const PathWalk* walk;
+    // 1 based index of the current segment, 0 at the end
+    size_t seg;
+    uint32_t idx {0};
+  };
+
+  const_iterator begin() const { return {this, segments.size()}; }
+  const_iterator end() const { return {this, 0}; }
+
+private:
+  std::shared_ptr<PathArena> arena;
+  // the last segment is the front of the walk
+  std::vector<Segment> segments;
+  size_t count {0};
+};
+
+} // namespace eos::common
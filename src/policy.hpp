@@ -0,0 +1,271 @@
+// ----------------------------------------------------------------------
+// File: policy.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "containerutils.hpp"
+#include "flatpolicymap.hpp"
+#include "swissmap.hpp"
+
+struct Policy {
+  //--------------------------------------------------------------------------
+  //! A policy key given as the concatenation prefix + suffix, so that a
+  //! composite key can be looked up without building it first
+  //--------------------------------------------------------------------------
+  struct SegmentedKey {
+    std::string_view prefix;
+    std::string_view suffix;
+  };
+
+  //--------------------------------------------------------------------------
+  //! Transparent comparator ordering keys exactly like std::less<std::string>
+  //! while also accepting SegmentedKey probes
+  //--------------------------------------------------------------------------
+  struct KeyLess {
+    using is_transparent = void;
+
+    // three way comparison of key against prefix + suffix
+    static int compare(std::string_view key, const SegmentedKey& sk) {
+      auto n = std::min(key.size(), sk.prefix.size());
+      if (int r = key.substr(0, n).compare(sk.prefix.substr(0, n)); r != 0) {
+        return r;
+      }
+      if (key.size() < sk.prefix.size()) {
+        return -1;
+      }
+      return key.substr(sk.prefix.size()).compare(sk.suffix);
+    }
+
+    bool operator()(std::string_view a, std::string_view b) const {
+      return a < b;
+    }
+
+    bool operator()(std::string_view a, const SegmentedKey& b) const {
+      return compare(a, b) < 0;
+    }
+
+    bool operator()(const SegmentedKey& a, std::string_view b) const {
+      return compare(b, a) > 0;
+    }
+  };
+
+  using PolicyMap = std::map<std::string, std::string, KeyLess>;
+
+  static std::vector<std::string> GetConfigKeys(const std::string& user_key,
+                                                const std::string& group_key,
+                                                const std::string& app_key,
+                                                bool is_rw,
+                                                bool local=false);
+
+  static std::vector<std::string> GetRWConfigKeys(const std::string& key_name,
+                                                    const std::string& user_key,
+                                                    const std::string& group_key,
+                                                    const std::string& app_key);
+
+  static std::string GetRWValue(const std::map<std::string, std::string>& conf_map,
+                                const std::string& key_name,
+                                const std::string& user_key,
+                                const std::string& group_key,
+                                const std::string& app_key);
+
+  //--------------------------------------------------------------------------
+  //! Same lookup as above, on a map supporting heterogeneous lookup the
+  //! composite keys are probed as segments so nothing gets allocated
+  //! besides the returned value
+  //--------------------------------------------------------------------------
+  static std::string GetRWValue(const PolicyMap& conf_map,
+                                std::string_view key_name,
+                                std::string_view user_key,
+                                std::string_view group_key,
+                                std::string_view app_key);
+
+  static std::string GetRWValue(const eos::common::FlatPolicyMap& conf_map,
+                                std::string_view key_name,
+                                std::string_view user_key,
+                                std::string_view group_key,
+                                std::string_view app_key);
+
+  static std::string GetRWValue(const eos::common::SwissStringMap& conf_map,
+                                std::string_view key_name,
+                                std::string_view user_key,
+                                std::string_view group_key,
+                                std::string_view app_key);
+
+  static std::string getRWkey(const std::string& key_name,
+                              bool is_rw,
+                              bool is_local=false);
+
+  static const std::vector<std::string> gBasePolicyKeys;
+  static const std::vector<std::string> gBasePolicyRWKeys;
+
+};
+
+inline const std::vector<std::string> Policy::gBasePolicyKeys = {
+  "policy.space",
+  "policy.layout",
+  "policy.nstripes",
+  "policy.checksum",
+  "policy.blockchecksum",
+  "policy.localredirect"
+};
+
+inline const std::string POLICY_BANDWIDTH="policy.bandwidth";
+inline const std::string POLICY_IOPRIORITY="policy.iopriority";
+inline const std::string POLICY_IOTYPE = "policy.iotype";
+inline const std::string POLICY_SCHEDULE="policy.schedule";
+inline const std::vector<std::string> Policy::gBasePolicyRWKeys = {
+  "policy.bandwidth",
+  "policy.iopriority",
+  "policy.iotype",
+  "policy.schedule"
+};
+
+
+inline std::vector<std::string>
+Policy::GetConfigKeys(const std::string& user_key,
+                      const std::string& group_key,
+                      const std::string& app_key,
+                      bool is_rw,
+                      bool local)
+{
+  std::string base_prefix;
+  std::vector<std::string> config_keys;
+  config_keys.reserve(22);
+  if (local) {
+    base_prefix = "local.";
+  }
+
+  // copy elements from base vector, with an optional prefix
+  std::transform(gBasePolicyKeys.cbegin(),
+                 gBasePolicyKeys.cend(),
+                 std::back_inserter(config_keys),
+                 [&base_prefix](const std::string& in) {
+                   return base_prefix + in;
+                 });
+
+
+  std::string rw_marker = is_rw ? ":w" : ":r";
+  for (const auto& _key: gBasePolicyRWKeys) {
+    eos::common::splice(config_keys,
+                        GetRWConfigKeys(getRWkey(_key, is_rw, local),
+                                        user_key, group_key, app_key));
+  }
+
+  return config_keys;
+}
+
+inline std::vector<std::string>
+Policy::GetRWConfigKeys(const std::string& key_name,
+                        const std::string& user_key,
+                        const std::string& group_key,
+                        const std::string& app_key)
+{
+
+  return {
+      key_name + app_key,
+      key_name + user_key,
+      key_name + group_key,
+      key_name
+  };
+}
+
+
+inline std::string
+Policy::GetRWValue(const std::map<std::string, std::string>& conf_map,
+                   const std::string& key_name,
+                   const std::string& user_key,
+                   const std::string& group_key,
+                   const std::string& app_key)
+{
+  for (const auto& k : GetRWConfigKeys(key_name, user_key, group_key, app_key)) {
+    if (const auto& kv = conf_map.find(k);
+        kv != conf_map.end() &&
+        !kv->second.empty()) {
+      return kv->second;
+    }
+  }
+  return {};
+}
+
+inline std::string
+Policy::GetRWValue(const PolicyMap& conf_map,
+                   std::string_view key_name,
+                   std::string_view user_key,
+                   std::string_view group_key,
+                   std::string_view app_key)
+{
+  for (auto suffix : {app_key, user_key, group_key, std::string_view()}) {
+    if (const auto& kv = conf_map.find(SegmentedKey{key_name, suffix});
+        kv != conf_map.end() &&
+        !kv->second.empty()) {
+      return kv->second;
+    }
+  }
+  return {};
+}
+
+inline std::string
+Policy::GetRWValue(const eos::common::FlatPolicyMap& conf_map,
+                   std::string_view key_name,
+                   std::string_view user_key,
+                   std::string_view group_key,
+                   std::string_view app_key)
+{
+  for (auto suffix : {app_key, user_key, group_key, std::string_view()}) {
+    if (auto v = conf_map.find(key_name, suffix); v && !v->empty()) {
+      return std::string(*v);
+    }
+  }
+  return {};
+}
+
+inline std::string
+Policy::GetRWValue(const eos::common::SwissStringMap& conf_map,
+                   std::string_view key_name,
+                   std::string_view user_key,
+                   std::string_view group_key,
+                   std::string_view app_key)
+{
+  for (auto suffix : {app_key, user_key, group_key, std::string_view()}) {
+    if (const auto& kv = conf_map.find(key_name, suffix);
+        kv != conf_map.end() &&
+        !kv->second.empty()) {
+      return kv->second;
+    }
+  }
+  return {};
+}
+
+inline std::string
+Policy::getRWkey(const std::string& key_name, bool is_rw, bool is_local)
+{
+  std::string base_prefix = is_local ? "local." : "";
+  std::string rw_marker = is_rw ? ":w" : ":r";
+  return base_prefix + key_name + rw_marker;
+}
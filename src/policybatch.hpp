@@ -0,0 +1,287 @@
+// ----------------------------------------------------------------------
+// File: policybatch.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "flatpolicymap.hpp"
+#include "resolvedpolicy.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! The identities of a batch of requests, one column per field
+//----------------------------------------------------------------------------
+struct PolicyRequestBatch {
+  std::vector<std::string_view> user_keys;
+  std::vector<std::string_view> group_keys;
+  std::vector<std::string_view> app_keys;
+  // (is_rw << 1) | local
+  std::vector<uint8_t> flags;
+
+  void add(std::string_view user_key, std::string_view group_key,
+           std::string_view app_key, bool is_rw, bool local = false) {
+    user_keys.push_back(user_key);
+    group_keys.push_back(group_key);
+    app_keys.push_back(app_key);
+    flags.push_back((is_rw << 1) | local);
+  }
+
+  void clear() {
+    user_keys.clear();
+    group_keys.clear();
+    app_keys.clear();
+    flags.clear();
+  }
+
+  size_t size() const { return flags.size(); }
+};
+
+//----------------------------------------------------------------------------
+//! The resolved values of a batch, one column per policy in the order of
+//! ResolvedPolicy, as views into the store they were resolved from
+//----------------------------------------------------------------------------
+struct ResolvedPolicyBatch {
+  std::array<std::vector<std::string_view>, 6> base;
+  std::array<std::vector<std::string_view>, 4> rw;
+
+  ResolvedPolicy operator[](size_t i) const {
+    ResolvedPolicy r;
+    for (size_t j = 0; j < base.size(); j++) {
+      r.base[j] = base[j][i];
+    }
+    for (size_t j = 0; j < rw.size(); j++) {
+      r.rw[j] = rw[j][i];
+    }
+    return r;
+  }
+
+  size_t size() const { return rw[0].size(); }
+};
+
+//----------------------------------------------------------------------------
+//! Resolves batches of requests with the precedence of ResolvePolicy, while
+//! sharing work between requests: the base and default RW values are probed
+//! once per (is_rw, local) combination, and the RW policies of every
+//! distinct app, user and group once per combination, however many requests
+//! carry them. On a FlatPolicyMap the probes are hashed up front and the
+//! store is prefetched ahead of the lookups. Keeps its scratch space between
+//! calls, so one resolver should be reused, but not shared between threads.
+//----------------------------------------------------------------------------
+class PolicyBatchResolver {
+public:
+  template <typename Map>
+  void resolve(const Map& conf_map, const PolicyRequestBatch& in,
+               ResolvedPolicyBatch& out) {
+    auto n = in.size();
+    for (auto& column: suffixes) {
+      column.clear(n);
+    }
+
+    bool used_flags[4] = {};
+    for (size_t i = 0; i < n; i++) {
+      auto f = in.flags[i];
+      used_flags[f] = true;
+      suffixes[kApp].add(f, in.app_keys[i]);
+      suffixes[kUser].add(f, in.user_keys[i]);
+      suffixes[kGroup].add(f, in.group_keys[i]);
+    }
+
+    // the probes of all distinct suffixes, and of the defaults for the used
+    // flags, as one list
+    probes.clear();
+    for (auto& column: suffixes) {
+      for (size_t u = 0; u < column.flags.size(); u++) {
+        const auto& parts = detail::PolicyTemplateFor(column.flags[u] >> 1,
+                                                      column.flags[u] & 1).get_parts();
+        for (size_t j = 0; j < kRW; j++) {
+          probes.add(parts[kBase + 4 * j].prefix, column.names[u]);
+        }
+      }
+    }
+
+    for (uint8_t f = 0; f < 4; f++) {
+      if (used_flags[f]) {
+        const auto& parts = detail::PolicyTemplateFor(f >> 1, f & 1).get_parts();
+        default_probe[f] = probes.size();
+        for (size_t j = 0; j < kBase; j++) {
+          probes.add(parts[j].prefix, {});
+        }
+        for (size_t j = 0; j < kRW; j++) {
+          probes.add(parts[kBase + 4 * j].prefix, {});
+        }
+      }
+    }
+
+    run_probes(conf_map);
+
+    for (auto& column: out.base) {
+      column.resize(n);
+    }
+    for (auto& column: out.rw) {
+      column.resize(n);
+    }
+
+    size_t app_base = 0;
+    size_t user_base = app_base + suffixes[kApp].flags.size() * kRW;
+    size_t group_base = user_base + suffixes[kUser].flags.size() * kRW;
+    for (size_t i = 0; i < n; i++) {
+      auto defaults = default_probe[in.flags[i]];
+      for (size_t j = 0; j < kBase; j++) {
+        out.base[j][i] = probes.values[defaults + j];
+      }
+
+      size_t candidates[] = {
+        app_base + suffixes[kApp].ids[i] * kRW,
+        user_base + suffixes[kUser].ids[i] * kRW,
+        group_base + suffixes[kGroup].ids[i] * kRW,
+        defaults + kBase
+      };
+      for (size_t j = 0; j < kRW; j++) {
+        std::string_view value;
+        for (auto c: candidates) {
+          if (!probes.values[c + j].empty()) {
+            value = probes.values[c + j];
+            break;
+          }
+        }
+        out.rw[j][i] = value;
+      }
+    }
+  }
+
+private:
+  static constexpr size_t kBase = 6;
+  static constexpr size_t kRW = 4;
+  enum { kApp, kUser, kGroup };
+  // probes to prefetch ahead of the current one
+  static constexpr size_t kPrefetchDistance = 8;
+
+  //--------------------------------------------------------------------------
+  //! Distinct (flags, suffix) pairs of one identity column, and the index of
+  //! the pair for every request
+  //--------------------------------------------------------------------------
+  struct SuffixColumn {
+    std::vector<uint8_t> flags;
+    std::vector<std::string_view> names;
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> slots;
+
+    void clear(size_t n) {
+      flags.clear();
+      names.clear();
+      hashes.clear();
+      ids.clear();
+      size_t nslots = 16;
+      while (nslots < 2 * n) {
+        nslots <<= 1;
+      }
+      slots.assign(nslots, UINT32_MAX);
+    }
+
+    void add(uint8_t f, std::string_view name) {
+      auto h = FlatPolicyMap::hash(name, {}) ^ (uint64_t(f) << 56);
+      size_t mask = slots.size() - 1;
+      for (size_t i = h & mask;; i = (i + 1) & mask) {
+        auto u = slots[i];
+        if (u == UINT32_MAX) {
+          slots[i] = flags.size();
+          ids.push_back(flags.size());
+          flags.push_back(f);
+          names.push_back(name);
+          hashes.push_back(h);
+          return;
+        }
+        if (hashes[u] == h && flags[u] == f && names[u] == name) {
+          ids.push_back(u);
+          return;
+        }
+      }
+    }
+  };
+
+  struct ProbeList {
+    std::vector<std::string_view> prefixes;
+    std::vector<std::string_view> suffixes;
+    std::vector<uint64_t> hashes;
+    std::vector<std::string_view> values;
+
+    void add(std::string_view prefix, std::string_view suffix) {
+      prefixes.push_back(prefix);
+      suffixes.push_back(suffix);
+    }
+
+    void clear() {
+      prefixes.clear();
+      suffixes.clear();
+      hashes.clear();
+      values.clear();
+    }
+
+    size_t size() const { return prefixes.size(); }
+  };
+
+  template <typename Map>
+  void run_probes(const Map& conf_map) {
+    auto n = probes.size();
+    probes.values.resize(n);
+    if constexpr (std::is_same_v<Map, FlatPolicyMap>) {
+      probes.hashes.resize(n);
+      for (size_t k = 0; k < n; k++) {
+        probes.hashes[k] = FlatPolicyMap::hash(probes.prefixes[k],
+                                               probes.suffixes[k]);
+      }
+
+      // slots two distances ahead, entries one distance ahead
+      for (size_t k = 0; k < n; k++) {
+        if (k + 2 * kPrefetchDistance < n) {
+          conf_map.prefetch_slot(probes.hashes[k + 2 * kPrefetchDistance]);
+        }
+        if (k + kPrefetchDistance < n) {
+          conf_map.prefetch_entry(probes.hashes[k + kPrefetchDistance]);
+        }
+        probes.values[k] = conf_map.find(probes.prefixes[k], probes.suffixes[k],
+                                         probes.hashes[k])
+                           .value_or(std::string_view());
+      }
+    } else {
+      for (size_t k = 0; k < n; k++) {
+        probes.values[k] = detail::PolicyProbe(conf_map, probes.prefixes[k],
+                                               probes.suffixes[k])
+                           .value_or(std::string_view());
+      }
+    }
+  }
+
+  std::array<SuffixColumn, 3> suffixes;
+  ProbeList probes;
+  size_t default_probe[4] = {};
+};
+
+} // namespace eos::common
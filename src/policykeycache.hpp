@@ -0,0 +1,177 @@
+// ----------------------------------------------------------------------
+// File: policykeycache.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lrucache.hpp"
+#include "policy.hpp"
+#include "smallvector.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! The set of policy keys for one identity, as built by
+//! Policy::GetConfigKeys, ready to be shared between threads
+//----------------------------------------------------------------------------
+struct PolicyKeySet {
+  std::vector<std::string> keys;
+
+  size_t footprint() const {
+    size_t bytes = sizeof(*this) + keys.capacity() * sizeof(std::string);
+    for (const auto& k: keys) {
+      // anything beyond the SSO buffer lives on the heap
+      if (k.capacity() > 15) {
+        bytes += k.capacity() + 1;
+      }
+    }
+    return bytes;
+  }
+};
+
+//----------------------------------------------------------------------------
+//! Policy::GetConfigKeys compiled for a given (is_rw, local) pair: every key
+//! is a fixed prefix, eg. "local.policy.iotype:w", plus optionally one of the
+//! identity keys. Expanding it for an identity is a single pass of exactly
+//! sized concatenations in the same order as GetConfigKeys.
+//----------------------------------------------------------------------------
+class PolicyKeyTemplate {
+public:
+  enum class Suffix : uint8_t { None, App, User, Group };
+
+  struct Part {
+    std::string prefix;
+    Suffix suffix;
+  };
+
+  PolicyKeyTemplate(bool is_rw, bool local) {
+    std::string base_prefix = local ? "local." : "";
+    for (const auto& key: Policy::gBasePolicyKeys) {
+      parts.push_back({base_prefix + key, Suffix::None});
+    }
+
+    // same precedence as Policy::GetRWConfigKeys
+    for (const auto& key: Policy::gBasePolicyRWKeys) {
+      auto rw_key = Policy::getRWkey(key, is_rw, local);
+      parts.push_back({rw_key, Suffix::App});
+      parts.push_back({rw_key, Suffix::User});
+      parts.push_back({rw_key, Suffix::Group});
+      parts.push_back({rw_key, Suffix::None});
+    }
+  }
+
+  std::vector<std::string> expand(std::string_view user_key,
+                                   std::string_view group_key,
+                                   std::string_view app_key) const {
+    std::vector<std::string> keys;
+    keys.reserve(parts.size());
+    for (const auto& part: parts) {
+      std::string_view suffix;
+      switch (part.suffix) {
+      case Suffix::App: suffix = app_key; break;
+      case Suffix::User: suffix = user_key; break;
+      case Suffix::Group: suffix = group_key; break;
+      case Suffix::None: break;
+      }
+
+      auto& key = keys.emplace_back();
+      key.reserve(part.prefix.size() + suffix.size());
+      key.append(part.prefix).append(suffix);
+    }
+    return keys;
+  }
+
+  const std::vector<Part>& get_parts() const { return parts; }
+
+private:
+  std::vector<Part> parts;
+};
+
+//----------------------------------------------------------------------------
+//! Build the cache key of an identity: the (is_rw, local) flags followed by
+//! the identity keys, each preceded by its length as 4 bytes, so that no two
+//! identities map to the same key whatever bytes their parts hold
+//----------------------------------------------------------------------------
+inline void MakeIdentityKey(SmallVector<char, 256>& key,
+                            std::string_view user_key,
+                            std::string_view group_key,
+                            std::string_view app_key,
+                            bool is_rw, bool local)
+{
+  key.clear();
+  key.push_back('0' + ((is_rw << 1) | local));
+  for (auto part: {user_key, group_key, app_key}) {
+    auto len = static_cast<uint32_t>(part.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+      key.push_back(static_cast<char>(len >> shift));
+    }
+    for (char c: part) {
+      key.push_back(c);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+//! Cache of policy key sets per (user_key, group_key, app_key, is_rw, local)
+//! identity, bounded by a memory budget and safe for concurrent use. A hit
+//! only builds the lookup key in a stack buffer and does not allocate; a miss
+//! expands the compiled template for the identity's flags.
+//----------------------------------------------------------------------------
+class PolicyKeyCache {
+public:
+  using value_type = std::shared_ptr<const PolicyKeySet>;
+
+  explicit PolicyKeyCache(size_t memory_budget, size_t nshards = 16) :
+    templates{PolicyKeyTemplate(false, false), PolicyKeyTemplate(false, true),
+              PolicyKeyTemplate(true, false), PolicyKeyTemplate(true, true)},
+    cache(memory_budget, nshards) {}
+
+  value_type get(std::string_view user_key, std::string_view group_key,
+                 std::string_view app_key, bool is_rw, bool local = false) {
+    size_t flags = (is_rw << 1) | local;
+    SmallVector<char, 256> key;
+    MakeIdentityKey(key, user_key, group_key, app_key, is_rw, local);
+
+    return cache.get_or_create(std::string_view(key.data(), key.size()),
+                               [&](std::string_view) {
+      auto set = std::make_shared<PolicyKeySet>();
+      set->keys = templates[flags].expand(user_key, group_key, app_key);
+      return set;
+    });
+  }
+
+  ShardedLruCache<PolicyKeySet>::Stats stats() const {
+    return cache.stats();
+  }
+
+private:
+  std::array<PolicyKeyTemplate, 4> templates;
+  ShardedLruCache<PolicyKeySet> cache;
+};
+
+} // namespace eos::common
@@ -0,0 +1,157 @@
+// ----------------------------------------------------------------------
+// File: policyworkload.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include "policy.hpp"
+#include "zipf.hpp"
+
+//----------------------------------------------------------------------------
+//! Knobs for the synthetic multi-tenant policy workload
+//----------------------------------------------------------------------------
+struct PolicyWorkloadConfig {
+  uint64_t users {1000};
+  // 0 picks users / 10 and users / 100
+  uint64_t groups {0};
+  uint64_t apps {0};
+  // fraction of users, groups and apps with their own RW policies
+  double policy_ratio {0.01};
+  // skew of the user and app popularity
+  double exponent {0.99};
+  // fraction of operations that update a policy instead of resolving one
+  double write_ratio {0.0};
+  uint64_t seed {42};
+};
+
+//----------------------------------------------------------------------------
+//! A policy store population and a matching stream of operations. The store
+//! has the default base and RW policies plus RW policies for a policy_ratio
+//! share of the users, groups and apps. Operations come from Zipf
+//! distributed users, each in a fixed group, using Zipf distributed apps.
+//----------------------------------------------------------------------------
+class PolicyWorkload {
+public:
+  struct Op {
+    bool write {false};
+    bool is_rw {false};
+    std::string user_key;
+    std::string group_key;
+    std::string app_key;
+    // set for writes only
+    std::string key;
+    std::string value;
+  };
+
+  //--------------------------------------------------------------------------
+  //! Produces operations, one per thread. The returned op is reused by the
+  //! next call so that generating does not allocate once warmed up.
+  //--------------------------------------------------------------------------
+  class Generator {
+  public:
+    Generator(const PolicyWorkload& w, uint64_t seed) :
+      w(w), gen(seed), user_dist(w.cfg.users, w.cfg.exponent),
+      app_dist(w.apps, w.cfg.exponent), write_dist(w.cfg.write_ratio) {}
+
+    const Op& next() {
+      auto user = user_dist(gen);
+      op.write = write_dist(gen);
+      op.is_rw = gen() & 1;
+      Name(op.user_key, ".user:u", user);
+      Name(op.group_key, ".group:g", user % w.groups);
+      Name(op.app_key, ".app:a", app_dist(gen));
+      if (op.write) {
+        op.key = Policy::getRWkey(Policy::gBasePolicyRWKeys[gen() % 4],
+                                  op.is_rw);
+        op.key += op.user_key;
+        op.value = std::to_string(++writes);
+      }
+      return op;
+    }
+
+  private:
+    const PolicyWorkload& w;
+    std::mt19937_64 gen;
+    ZipfDistribution user_dist;
+    ZipfDistribution app_dist;
+    std::bernoulli_distribution write_dist;
+    uint64_t writes {0};
+    Op op;
+  };
+
+  explicit PolicyWorkload(const PolicyWorkloadConfig& cfg) :
+    cfg(cfg),
+    groups(cfg.groups ? cfg.groups : std::max<uint64_t>(1, cfg.users / 10)),
+    apps(cfg.apps ? cfg.apps : std::max<uint64_t>(1, cfg.users / 100)) {}
+
+  //--------------------------------------------------------------------------
+  //! Call f(key, value) for every policy of the initial store
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void for_each_policy(F&& f) const {
+    for (const auto& key: Policy::gBasePolicyKeys) {
+      f(key, std::string("default"));
+    }
+
+    std::string name;
+    for (bool is_rw: {false, true}) {
+      for (const auto& key: Policy::gBasePolicyRWKeys) {
+        auto rw_key = Policy::getRWkey(key, is_rw);
+        f(rw_key, std::string("default"));
+        for (auto [prefix, n]: {std::pair{".user:u", cfg.users},
+                                std::pair{".group:g", groups},
+                                std::pair{".app:a", apps}}) {
+          for (uint64_t i = 0; i < n; i++) {
+            if (HasPolicy(i)) {
+              Name(name, prefix, i);
+              f(rw_key + name, std::to_string(i));
+            }
+          }
+        }
+      }
+    }
+  }
+
+  const PolicyWorkloadConfig& config() const { return cfg; }
+
+private:
+  // spread the identities with policies over the popularity ranks
+  bool HasPolicy(uint64_t i) const {
+    return ((i * 0x9E3779B97F4A7C15ull) >> 11) <
+           cfg.policy_ratio * double(1ull << 53);
+  }
+
+  static void Name(std::string& out, const char* prefix, uint64_t i) {
+    out.assign(prefix);
+    out += std::to_string(i);
+  }
+
+  PolicyWorkloadConfig cfg;
+  uint64_t groups;
+  uint64_t apps;
+};
@@ -0,0 +1,138 @@
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "radixtree.hpp"
+#include "benchmark/benchmark.h"
+
+// Directory nodes carrying an attribute (eg. a quota node id), spread over a
+// few instances and projects with one directory per user underneath
+static std::string NodePath(int64_t i)
+{
+  return "/eos/inst" + std::to_string(i % 8) + "/proj" +
+         std::to_string((i / 8) % 128) + "/u" + std::to_string(i) + "/";
+}
+
+// Lookups are files a few levels below a random node, every 10th one is
+// outside of all nodes and misses
+static std::vector<std::string> MakeLookups(int64_t nodes, size_t n)
+{
+  std::mt19937_64 gen(42);
+  std::vector<std::string> lookups;
+  lookups.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    std::string base = (i % 10 == 9) ? "/scratch/tmp/" : NodePath(gen() % nodes);
+    lookups.emplace_back(base + "data/run" + std::to_string(gen() % 100) +
+                         "/file" + std::to_string(i) + ".root");
+  }
+  return lookups;
+}
+
+// The usual upward walk, the path is split and every candidate prefix is
+// rebuilt as a std::string to probe the map from the deepest level up
+static const uint64_t* MapLongestPrefix(const std::map<std::string, uint64_t>& m,
+                                        const std::string& path)
+{
+  std::vector<std::string> parts;
+  for (auto p: eos::common::LazySplit<std::string_view, char>(path, '/')) {
+    parts.emplace_back(p);
+  }
+
+  for (size_t depth = parts.size() + 1; depth-- > 0;) {
+    std::string prefix = "/";
+    for (size_t i = 0; i < depth; i++) {
+      prefix += parts[i];
+      prefix += '/';
+    }
+
+    if (auto it = m.find(prefix); it != m.end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+static void BM_MapLongestPrefix(benchmark::State& state) {
+  std::map<std::string, uint64_t> m;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    m.emplace(NodePath(i), i);
+  }
+  auto lookups = MakeLookups(state.range(0), 4096);
+  size_t i = 0;
+  for (auto _: state) {
+    benchmark::DoNotOptimize(MapLongestPrefix(m, lookups[i++ & 4095]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_RadixLongestPrefix(benchmark::State& state) {
+  eos::common::PathRadixTree<uint64_t> tree;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    tree.insert_or_assign(NodePath(i), i);
+  }
+  auto lookups = MakeLookups(state.range(0), 4096);
+  size_t i = 0;
+  for (auto _: state) {
+    benchmark::DoNotOptimize(tree.longest_prefix(lookups[i++ & 4095]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Readers sharing one tree, only the read lock is contended
+static void BM_RadixLongestPrefixShared(benchmark::State& state) {
+  static std::unique_ptr<eos::common::PathRadixTree<uint64_t>> tree;
+  static std::vector<std::string> lookups;
+  if (state.thread_index() == 0) {
+    tree = std::make_unique<eos::common::PathRadixTree<uint64_t>>();
+    for (int64_t i = 0; i < state.range(0); i++) {
+      tree->insert_or_assign(NodePath(i), i);
+    }
+    lookups = MakeLookups(state.range(0), 4096);
+  }
+
+  size_t i = state.thread_index() * 997;
+  for (auto _: state) {
+    benchmark::DoNotOptimize(tree->longest_prefix(lookups[i++ & 4095]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_MapSubtree(benchmark::State& state) {
+  std::map<std::string, uint64_t> m;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    m.emplace(NodePath(i), i);
+  }
+  const std::string prefix = "/eos/inst3/proj7/";
+  for (auto _: state) {
+    uint64_t sum = 0;
+    for (auto it = m.lower_bound(prefix);
+         it != m.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+      sum += it->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+static void BM_RadixSubtree(benchmark::State& state) {
+  eos::common::PathRadixTree<uint64_t> tree;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    tree.insert_or_assign(NodePath(i), i);
+  }
+  for (auto _: state) {
+    uint64_t sum = 0;
+    tree.for_each_prefix("/eos/inst3/proj7/", [&sum](std::string_view, uint64_t v) {
+      sum += v;
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+int64_t start = 10000;
+int64_t end = 10000000;
+BENCHMARK(BM_MapLongestPrefix)->RangeMultiplier(10)->Range(start, end);
+BENCHMARK(BM_RadixLongestPrefix)->RangeMultiplier(10)->Range(start, end);
+BENCHMARK(BM_RadixLongestPrefixShared)->Arg(1000000)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK(BM_MapSubtree)->RangeMultiplier(10)->Range(start, end)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RadixSubtree)->RangeMultiplier(10)->Range(start, end)->Unit(benchmark::kMicrosecond);
+BENCHMARK_MAIN();
@@ -0,0 +1,344 @@
+// ----------------------------------------------------------------------
+// File: radixtree.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "lazysplit.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Compressed radix tree keyed by path components, meant for resolving per
+//! directory attributes (quota nodes, space policies, ACLs) by longest prefix
+//! match. A chain of nodes with a single child and no value is collapsed into
+//! one edge holding several components, so the depth of the tree is bounded
+//! by the number of branching points rather than by the path depth.
+//!
+//! Lookups consume LazySplit tokens directly and compare them against the
+//! stored edges, so they do not allocate. All operations take an internal
+//! reader-writer lock, any number of readers run concurrently with each other
+//! and are serialized against writers only.
+//!
+//! @tparam V the value type, returned by copy from lookups so prefer cheap to
+//!           copy types (ids, pointers) or use the visitor overloads
+//----------------------------------------------------------------------------
+template <typename V>
+class PathRadixTree {
+  using split_type = LazySplit<std::string_view, char>;
+
+  struct Node {
+    // components leading to this node from its parent, empty for the root
+    std::vector<std::string> edge;
+    std::optional<V> value;
+    // sorted by the first component of their edge
+    std::vector<std::unique_ptr<Node>> children;
+
+    static bool less(const std::unique_ptr<Node>& c, std::string_view s) {
+      return c->edge.front() < s;
+    }
+
+    auto child_pos(std::string_view first) {
+      return std::lower_bound(children.begin(), children.end(), first, less);
+    }
+
+    auto child_pos(std::string_view first) const {
+      return std::lower_bound(children.begin(), children.end(), first, less);
+    }
+
+    Node* find_child(std::string_view first) const {
+      auto it = child_pos(first);
+      if (it != children.end() && (*it)->edge.front() == first) {
+        return it->get();
+      }
+      return nullptr;
+    }
+  };
+
+public:
+  PathRadixTree() : root(std::make_unique<Node>()) {}
+
+  //--------------------------------------------------------------------------
+  //! Insert a value for a path or replace the existing one
+  //!
+  //! @return true if a new entry was created
+  //--------------------------------------------------------------------------
+  bool insert_or_assign(std::string_view path, V value) {
+    std::vector<std::string_view> toks;
+    for (auto t: split_type(path, '/')) {
+      toks.push_back(t);
+    }
+
+    std::unique_lock lock(mtx);
+    Node* n = root.get();
+    size_t i = 0;
+    while (i < toks.size()) {
+      auto it = n->child_pos(toks[i]);
+      if (it == n->children.end() || (*it)->edge.front() != toks[i]) {
+        auto child = std::make_unique<Node>();
+        child->edge.assign(toks.begin() + i, toks.end());
+        child->value = std::move(value);
+        n->children.insert(it, std::move(child));
+        ++count;
+        return true;
+      }
+
+      Node* c = it->get();
+      size_t j = 0;
+      while (j < c->edge.size() && i < toks.size() && c->edge[j] == toks[i]) {
+        ++i;
+        ++j;
+      }
+
+      if (j < c->edge.size()) {
+        // the path diverges or ends within the edge, split it at j
+        auto mid = std::make_unique<Node>();
+        mid->edge.assign(std::make_move_iterator(c->edge.begin()),
+                         std::make_move_iterator(c->edge.begin() + j));
+        c->edge.erase(c->edge.begin(), c->edge.begin() + j);
+        mid->children.push_back(std::move(*it));
+        *it = std::move(mid);
+        c = it->get();
+      }
+      n = c;
+    }
+
+    bool created = !n->value.has_value();
+    n->value = std::move(value);
+    count += created;
+    return created;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Remove the value stored for exactly this path, nodes left without a
+  //! value are pruned or merged back into their single child.
+  //!
+  //! @return true if an entry was removed
+  //--------------------------------------------------------------------------
+  bool erase(std::string_view path) {
+    std::unique_lock lock(mtx);
+    std::vector<Node*> parents;
+    Node* n = walk(path, &parents);
+    if (!n || !n->value) {
+      return false;
+    }
+
+    n->value.reset();
+    --count;
+
+    // prune the emptied node, which may leave its parent prunable in turn
+    for (size_t level = parents.size(); level > 0 && n != root.get(); --level) {
+      Node* parent = parents[level - 1];
+      if (n->value) {
+        break;
+      }
+
+      auto it = parent->child_pos(n->edge.front());
+      if (n->children.empty()) {
+        parent->children.erase(it);
+      } else if (n->children.size() == 1) {
+        auto child = std::move(n->children.front());
+        child->edge.insert(child->edge.begin(),
+                           std::make_move_iterator(n->edge.begin()),
+                           std::make_move_iterator(n->edge.end()));
+        *it = std::move(child);
+        break;
+      } else {
+        break;
+      }
+      n = parent;
+    }
+    return true;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Exact match lookup
+  //--------------------------------------------------------------------------
+  std::optional<V> find(std::string_view path) const {
+    std::shared_lock lock(mtx);
+    if (const Node* n = walk(path); n) {
+      return n->value;
+    }
+    return std::nullopt;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Longest prefix match, calls f(value, depth) with the value of the
+  //! deepest entry that is a prefix of path (on component boundaries) and the
+  //! number of components it matched. f runs under the read lock.
+  //!
+  //! @return true if any prefix matched
+  //--------------------------------------------------------------------------
+  template <typename F>
+  bool longest_prefix(std::string_view path, F&& f) const {
+    std::shared_lock lock(mtx);
+    const Node* n = root.get();
+    const Node* best = n->value ? n : nullptr;
+    size_t depth = 0, best_depth = 0;
+    split_type parts(path, '/');
+    auto it = parts.begin();
+    auto end = parts.end();
+
+    while (it != end) {
+      const Node* c = n->find_child(*it);
+      if (!c) {
+        break;
+      }
+
+      bool full = true;
+      for (const auto& e: c->edge) {
+        if (it == end || *it != e) {
+          full = false;
+          break;
+        }
+        ++it;
+        ++depth;
+      }
+
+      if (!full) {
+        break;
+      }
+
+      n = c;
+      if (n->value) {
+        best = n;
+        best_depth = depth;
+      }
+    }
+
+    if (best) {
+      f(*best->value, best_depth);
+      return true;
+    }
+    return false;
+  }
+
+  std::optional<V> longest_prefix(std::string_view path) const {
+    std::optional<V> result;
+    longest_prefix(path, [&result](const V& v, size_t) { result = v; });
+    return result;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Visit every entry at or below prefix, f(path, value) gets the full path
+  //! of the entry as "/c1/c2/.../cn/". f runs under the read lock.
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void for_each_prefix(std::string_view prefix, F&& f) const {
+    std::shared_lock lock(mtx);
+    const Node* n = root.get();
+    std::string path = "/";
+    split_type parts(prefix, '/');
+    auto it = parts.begin();
+    auto end = parts.end();
+
+    while (it != end) {
+      const Node* c = n->find_child(*it);
+      if (!c) {
+        return;
+      }
+
+      for (const auto& e: c->edge) {
+        // a prefix ending within an edge still selects the whole child
+        if (it != end) {
+          if (*it != e) {
+            return;
+          }
+          ++it;
+        }
+        path.append(e).push_back('/');
+      }
+      n = c;
+    }
+
+    visit(n, path, f);
+  }
+
+  size_t size() const {
+    std::shared_lock lock(mtx);
+    return count;
+  }
+
+private:
+  const Node* walk(std::string_view path,
+                   std::vector<Node*>* parents = nullptr) const {
+    const Node* n = root.get();
+    split_type parts(path, '/');
+    auto it = parts.begin();
+    auto end = parts.end();
+
+    while (it != end) {
+      const Node* c = n->find_child(*it);
+      if (!c) {
+        return nullptr;
+      }
+
+      for (const auto& e: c->edge) {
+        if (it == end || *it != e) {
+          return nullptr;
+        }
+        ++it;
+      }
+
+      if (parents) {
+        parents->push_back(const_cast<Node*>(n));
+      }
+      n = c;
+    }
+    return n;
+  }
+
+  Node* walk(std::string_view path, std::vector<Node*>* parents) {
+    return const_cast<Node*>(std::as_const(*this).walk(path, parents));
+  }
+
+  template <typename F>
+  static void visit(const Node* n, std::string& path, F& f) {
+    if (n->value) {
+      f(std::string_view(path), *n->value);
+    }
+
+    for (const auto& c: n->children) {
+      auto len = path.size();
+      for (const auto& e: c->edge) {
+        path.append(e).push_back('/');
+      }
+      visit(c.get(), path, f);
+      path.resize(len);
+    }
+  }
+
+  mutable std::shared_mutex mtx;
+  std::unique_ptr<Node> root;
+  size_t count {0};
+};
+
+} // namespace eos::common
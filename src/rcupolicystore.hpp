@@ -0,0 +1,283 @@
+// ----------------------------------------------------------------------
+// File: rcupolicystore.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "flatpolicymap.hpp"
+
+namespace eos::common {
+
+namespace detail {
+
+//----------------------------------------------------------------------------
+//! Hands out small, process wide unique indices to threads, an index is
+//! returned when its thread exits and may then be reused. Used to give every
+//! reader thread its own epoch slot.
+//----------------------------------------------------------------------------
+class ThreadSlots {
+public:
+  static constexpr size_t kMaxSlots = 512;
+  static constexpr size_t kNoSlot = SIZE_MAX;
+
+  //! the index of the calling thread, kNoSlot if all are taken
+  static size_t self() {
+    thread_local Holder holder;
+    return holder.index;
+  }
+
+  //! one past the highest index handed out so far. Both this load and the
+  //! store in acquire() are seq_cst: a writer scanning up to the high water
+  //! relies on the same total order as the slot announce and the snapshot
+  //! pointer swap, or it could miss the slot of a thread that just joined.
+  static size_t high_water() {
+    return instance().high.load();
+  }
+
+private:
+  struct Holder {
+    Holder() : index(instance().acquire()) {}
+    ~Holder() { instance().release(index); }
+    size_t index;
+  };
+
+  static ThreadSlots& instance() {
+    static ThreadSlots slots;
+    return slots;
+  }
+
+  size_t acquire() {
+    std::lock_guard lock(mtx);
+    for (size_t i = 0; i < kMaxSlots; i++) {
+      if (!used[i]) {
+        used[i] = true;
+        if (i >= high.load(std::memory_order_relaxed)) {
+          high.store(i + 1);
+        }
+        return i;
+      }
+    }
+    return kNoSlot;
+  }
+
+  void release(size_t i) {
+    if (i != kNoSlot) {
+      std::lock_guard lock(mtx);
+      used[i] = false;
+    }
+  }
+
+  std::mutex mtx;
+  bool used[kMaxSlots] {};
+  std::atomic<size_t> high {0};
+};
+
+} // namespace detail
+
+//----------------------------------------------------------------------------
+//! Policy store for many readers and rare writers. Readers see an immutable
+//! FlatPolicyMap snapshot, writers copy the current snapshot, modify the copy
+//! and publish it with a single pointer swap, so several updates should be
+//! batched with update().
+//!
+//! Reads are wait-free: a reader announces the current epoch in its own
+//! cache line sized slot, loads the snapshot pointer, and clears the slot
+//! when done. A replaced snapshot is retired with the epoch at which it was
+//! replaced and freed by a later writer once no slot announces an epoch at or
+//! below that one. Threads beyond ThreadSlots::kMaxSlots fall back to taking
+//! a reference under the writer lock.
+//----------------------------------------------------------------------------
+class RcuPolicyStore {
+  using snapshot_ptr = std::shared_ptr<const FlatPolicyMap>;
+
+public:
+  //--------------------------------------------------------------------------
+  //! Keeps a snapshot alive, views obtained from it are valid as long as the
+  //! guard is. Guards must not outlive the store or move between threads;
+  //! nesting them on one thread is fine.
+  //--------------------------------------------------------------------------
+  class ReadGuard {
+  public:
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    ~ReadGuard() {
+      if (slot) {
+        slot->store(kIdle, std::memory_order_release);
+      }
+    }
+
+    const FlatPolicyMap& operator*() const { return *snapshot; }
+    const FlatPolicyMap* operator->() const { return snapshot; }
+
+  private:
+    friend class RcuPolicyStore;
+
+    explicit ReadGuard(const RcuPolicyStore& store) {
+      auto idx = detail::ThreadSlots::self();
+      if (idx == detail::ThreadSlots::kNoSlot) {
+        std::lock_guard lock(store.write_mtx);
+        owner = store.current_owner;
+        snapshot = owner.get();
+        return;
+      }
+
+      auto& s = store.slots[idx].epoch;
+      // an enclosing guard on this thread already protects every snapshot
+      // that can be retired from here on
+      if (s.load(std::memory_order_relaxed) == kIdle) {
+        s.store(store.epoch.load());
+        slot = &s;
+      }
+      snapshot = store.current.load();
+    }
+
+    std::atomic<uint64_t>* slot {nullptr};
+    const FlatPolicyMap* snapshot {nullptr};
+    snapshot_ptr owner;
+  };
+
+  RcuPolicyStore() :
+    slots(std::make_unique<Slot[]>(detail::ThreadSlots::kMaxSlots)),
+    current_owner(std::make_shared<const FlatPolicyMap>()),
+    current(current_owner.get()) {}
+
+  RcuPolicyStore(const RcuPolicyStore&) = delete;
+  RcuPolicyStore& operator=(const RcuPolicyStore&) = delete;
+
+  ReadGuard read() const {
+    return ReadGuard(*this);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Call f(const FlatPolicyMap&) on the current snapshot, views into the
+  //! snapshot must not escape f
+  //--------------------------------------------------------------------------
+  template <typename F>
+  decltype(auto) read(F&& f) const {
+    auto guard = read();
+    return f(*guard);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup the keys in [first, last) on one snapshot with
+  //! FlatPolicyMap::find_batch, the values are assigned to the strings at
+  //! out so that they can be reused between batches. Absent keys give empty
+  //! strings, same as unset policies.
+  //--------------------------------------------------------------------------
+  template <typename KeyIt, typename OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const {
+    auto guard = read();
+    std::optional<std::string_view> found[FlatPolicyMap::kBatchGroup];
+    while (first != last) {
+      auto next = first;
+      size_t n = 0;
+      for (; next != last && n < FlatPolicyMap::kBatchGroup; ++next, ++n) {}
+      guard->find_batch(first, next, found);
+      for (size_t i = 0; i < n; i++, ++out) {
+        out->assign(found[i].value_or(std::string_view()));
+      }
+      first = next;
+    }
+    return out;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Apply f(FlatPolicyMap&) to a copy of the current snapshot and publish
+  //! it, readers see either none or all of the changes made by f
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void update(F&& f) {
+    std::lock_guard lock(write_mtx);
+    auto next = std::make_shared<FlatPolicyMap>(*current_owner);
+    f(*next);
+    publish(std::move(next));
+  }
+
+  void insert_or_assign(std::string_view key, std::string_view value) {
+    update([&](FlatPolicyMap& m) { m.insert_or_assign(key, value); });
+  }
+
+  template <typename Pred>
+  size_t erase_if(Pred pred) {
+    size_t n = 0;
+    update([&](FlatPolicyMap& m) { n = m.erase_if(pred); });
+    return n;
+  }
+
+  //! number of replaced snapshots not yet freed
+  size_t retired_count() const {
+    std::lock_guard lock(write_mtx);
+    return retired.size();
+  }
+
+private:
+  static constexpr uint64_t kIdle = UINT64_MAX;
+
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch {kIdle};
+  };
+
+  struct Retired {
+    snapshot_ptr snapshot;
+    uint64_t epoch;
+  };
+
+  // expects write_mtx to be held
+  void publish(snapshot_ptr next) {
+    current.store(next.get());
+    auto e = epoch.fetch_add(1);
+    retired.push_back({std::move(current_owner), e});
+    current_owner = std::move(next);
+
+    // a reader that loaded a retired pointer announced an epoch <= the one
+    // it was retired with, any later reader sees a newer pointer
+    uint64_t oldest = kIdle;
+    for (size_t i = 0, n = detail::ThreadSlots::high_water(); i < n; i++) {
+      oldest = std::min(oldest, slots[i].epoch.load());
+    }
+
+    retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                 [oldest](const Retired& r) {
+                                   return r.epoch < oldest;
+                                 }),
+                  retired.end());
+  }
+
+  std::unique_ptr<Slot[]> slots;
+  std::atomic<uint64_t> epoch {1};
+  mutable std::mutex write_mtx;
+  snapshot_ptr current_owner;
+  std::atomic<const FlatPolicyMap*> current;
+  std::vector<Retired> retired;
+};
+
+} // namespace eos::common
@@ -0,0 +1,165 @@
+// ----------------------------------------------------------------------
+// File: resolvedpolicy.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "flatpolicymap.hpp"
+#include "policy.hpp"
+#include "policykeycache.hpp"
+#include "swissmap.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! The effective values of all policies for one identity, as views into the
+//! policy store they were resolved from. They stay valid only as long as the
+//! store is not modified. Unset policies are empty.
+//----------------------------------------------------------------------------
+struct ResolvedPolicy {
+  // in the order of Policy::gBasePolicyKeys and Policy::gBasePolicyRWKeys
+  std::array<std::string_view, 6> base;
+  std::array<std::string_view, 4> rw;
+
+  std::string_view space() const { return base[0]; }
+  std::string_view layout() const { return base[1]; }
+  std::string_view nstripes() const { return base[2]; }
+  std::string_view checksum() const { return base[3]; }
+  std::string_view blockchecksum() const { return base[4]; }
+  std::string_view localredirect() const { return base[5]; }
+
+  std::string_view bandwidth() const { return rw[0]; }
+  std::string_view iopriority() const { return rw[1]; }
+  std::string_view iotype() const { return rw[2]; }
+  std::string_view schedule() const { return rw[3]; }
+};
+
+namespace detail {
+
+inline std::optional<std::string_view>
+PolicyProbe(const Policy::PolicyMap& m, std::string_view prefix,
+            std::string_view suffix)
+{
+  if (auto kv = m.find(Policy::SegmentedKey{prefix, suffix}); kv != m.end()) {
+    return kv->second;
+  }
+  return std::nullopt;
+}
+
+inline std::optional<std::string_view>
+PolicyProbe(const FlatPolicyMap& m, std::string_view prefix,
+            std::string_view suffix)
+{
+  return m.find(prefix, suffix);
+}
+
+inline std::optional<std::string_view>
+PolicyProbe(const SwissStringMap& m, std::string_view prefix,
+            std::string_view suffix)
+{
+  if (auto kv = m.find(prefix, suffix); kv != m.end()) {
+    return kv->second;
+  }
+  return std::nullopt;
+}
+
+// no heterogeneous lookup here, the key has to be built
+inline std::optional<std::string_view>
+PolicyProbe(const std::map<std::string, std::string>& m,
+            std::string_view prefix, std::string_view suffix)
+{
+  std::string key;
+  key.reserve(prefix.size() + suffix.size());
+  key.append(prefix).append(suffix);
+  if (auto kv = m.find(key); kv != m.end()) {
+    return kv->second;
+  }
+  return std::nullopt;
+}
+
+inline const PolicyKeyTemplate& PolicyTemplateFor(bool is_rw, bool local)
+{
+  static const std::array<PolicyKeyTemplate, 4> templates = {
+    PolicyKeyTemplate(false, false), PolicyKeyTemplate(false, true),
+    PolicyKeyTemplate(true, false), PolicyKeyTemplate(true, true)
+  };
+  return templates[(is_rw << 1) | local];
+}
+
+} // namespace detail
+
+//----------------------------------------------------------------------------
+//! Resolve all base and RW policies of an identity in one pass over the
+//! precomputed key names, with the same precedence as Policy::GetRWValue:
+//! app > user > group > default, empty values do not count as set.
+//!
+//! @param conf_map the policy store, any of std::map<std::string,
+//!        std::string>, Policy::PolicyMap, FlatPolicyMap or SwissStringMap
+//----------------------------------------------------------------------------
+template <typename Map>
+ResolvedPolicy ResolvePolicy(const Map& conf_map,
+                             std::string_view user_key,
+                             std::string_view group_key,
+                             std::string_view app_key,
+                             bool is_rw,
+                             bool local = false)
+{
+  using Suffix = PolicyKeyTemplate::Suffix;
+  ResolvedPolicy resolved;
+  const auto& parts = detail::PolicyTemplateFor(is_rw, local).get_parts();
+  auto part = parts.begin();
+  for (auto& value: resolved.base) {
+    value = detail::PolicyProbe(conf_map, part->prefix, {})
+            .value_or(std::string_view());
+    ++part;
+  }
+
+  // each RW policy is a group of four parts in precedence order
+  for (auto& value: resolved.rw) {
+    auto group_end = part + 4;
+    for (; part != group_end; ++part) {
+      std::string_view suffix;
+      switch (part->suffix) {
+      case Suffix::App: suffix = app_key; break;
+      case Suffix::User: suffix = user_key; break;
+      case Suffix::Group: suffix = group_key; break;
+      case Suffix::None: break;
+      }
+
+      if (auto v = detail::PolicyProbe(conf_map, part->prefix, suffix);
+          v && !v->empty()) {
+        value = *v;
+        part = group_end;
+        break;
+      }
+    }
+  }
+  return resolved;
+}
+
+} // namespace eos::common
@@ -0,0 +1,143 @@
+// ----------------------------------------------------------------------
+// File: shardedmap.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "swissmap.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! String to string map for many concurrent readers and writers. Keys are
+//! spread by hash over a power of 2 number of shards, each a SwissStringMap
+//! behind its own lock in a cache line aligned header, so threads working on
+//! different shards share neither a lock nor a cache line. With a
+//! std::shared_mutex readers of one shard proceed in parallel, with a
+//! std::mutex they are serialized but each lock is cheaper.
+//!
+//! Values are copied out under the lock; an optimistic (seqlock) read is not
+//! an option since a concurrent writer may free the string being read.
+//!
+//! @tparam Mutex the lock of every shard
+//----------------------------------------------------------------------------
+template <typename Mutex = std::shared_mutex>
+class ShardedStringMap {
+public:
+  //--------------------------------------------------------------------------
+  //! @param nshards number of shards, rounded up to a power of 2
+  //--------------------------------------------------------------------------
+  explicit ShardedStringMap(size_t nshards = 16) {
+    size_t n = 1;
+    while (n < nshards) {
+      n <<= 1;
+    }
+    shard_mask = n - 1;
+    shards = std::make_unique<Shard[]>(n);
+  }
+
+  std::optional<std::string> find(std::string_view key) const {
+    auto& shard = shard_for(key);
+    auto lock = read_lock(shard);
+    if (auto kv = shard.map.find(key); kv != shard.map.end()) {
+      return kv->second;
+    }
+    return std::nullopt;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Call f(std::string_view) on the value of key under the shard's read
+  //! lock, the view must not escape f
+  //!
+  //! @return whether key was found
+  //--------------------------------------------------------------------------
+  template <typename F>
+  bool visit(std::string_view key, F&& f) const {
+    auto& shard = shard_for(key);
+    auto lock = read_lock(shard);
+    if (auto kv = shard.map.find(key); kv != shard.map.end()) {
+      f(std::string_view(kv->second));
+      return true;
+    }
+    return false;
+  }
+
+  //--------------------------------------------------------------------------
+  //! @return true if the key was inserted, false if it was overwritten
+  //--------------------------------------------------------------------------
+  bool insert_or_assign(std::string_view key, std::string_view value) {
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mtx);
+    return shard.map.insert_or_assign(key, value).second;
+  }
+
+  bool erase(std::string_view key) {
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mtx);
+    return shard.map.erase(key);
+  }
+
+  //! not a snapshot, shards are counted one after the other
+  size_t size() const {
+    size_t n = 0;
+    for (size_t i = 0; i <= shard_mask; i++) {
+      auto lock = read_lock(shards[i]);
+      n += shards[i].map.size();
+    }
+    return n;
+  }
+
+  size_t shard_count() const { return shard_mask + 1; }
+
+private:
+  struct alignas(64) Shard {
+    mutable Mutex mtx;
+    SwissStringMap map;
+  };
+
+  static auto read_lock(const Shard& shard) {
+    if constexpr (std::is_same_v<Mutex, std::shared_mutex>) {
+      return std::shared_lock(shard.mtx);
+    } else {
+      return std::unique_lock(shard.mtx);
+    }
+  }
+
+  // SwissStringMap uses the low bits of its own hash, so the shard is
+  // picked with a different one
+  Shard& shard_for(std::string_view key) const {
+    return shards[std::hash<std::string_view>{}(key) & shard_mask];
+  }
+
+  size_t shard_mask;
+  std::unique_ptr<Shard[]> shards;
+};
+
+} // namespace eos::common
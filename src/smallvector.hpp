@@ -0,0 +1,250 @@
+// ----------------------------------------------------------------------
+// File: smallvector.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! A vector with inline storage for N elements, it only allocates once it
+//! grows past N. Meant for split results where the typical number of tokens
+//! is known (path depth), so the common case does not touch the heap at all.
+//! Supports the subset of the std::vector interface the split helpers need;
+//! like std::vector, growing invalidates iterators and references.
+//!
+//! @tparam T element type
+//! @tparam N number of inline elements
+//----------------------------------------------------------------------------
+template <typename T, size_t N>
+class SmallVector {
+  static_assert(N > 0, "use std::vector for no inline storage");
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SmallVector() = default;
+
+  SmallVector(std::initializer_list<T> il) {
+    assign(il.begin(), il.end());
+  }
+
+  template <typename It,
+            typename = typename std::iterator_traits<It>::iterator_category>
+  SmallVector(It first, It last) {
+    assign(first, last);
+  }
+
+  SmallVector(const SmallVector& other) {
+    assign(other.begin(), other.end());
+  }
+
+  SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    take(std::move(other));
+  }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      release();
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  ~SmallVector() {
+    clear();
+    release();
+  }
+
+  template <typename It>
+  void assign(It first, It last) {
+    clear();
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                  typename std::iterator_traits<It>::iterator_category>) {
+      reserve(std::distance(first, last));
+    }
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  template <typename... Args>
+  reference emplace_back(Args&&... args) {
+    if (sz == cap) {
+      return grow_and_emplace(std::forward<Args>(args)...);
+    }
+    ::new (static_cast<void*>(ptr + sz)) T(std::forward<Args>(args)...);
+    return ptr[sz++];
+  }
+
+  void push_back(const T& v) { emplace_back(v); }
+  void push_back(T&& v) { emplace_back(std::move(v)); }
+
+  void pop_back() {
+    ptr[--sz].~T();
+  }
+
+  void clear() {
+    std::destroy(ptr, ptr + sz);
+    sz = 0;
+  }
+
+  void reserve(size_t n) {
+    if (n > cap) {
+      grow(n);
+    }
+  }
+
+  void resize(size_t n) {
+    reserve(n);
+    while (sz > n) {
+      pop_back();
+    }
+    while (sz < n) {
+      emplace_back();
+    }
+  }
+
+  reference operator[](size_t i) { return ptr[i]; }
+  const_reference operator[](size_t i) const { return ptr[i]; }
+  reference front() { return ptr[0]; }
+  const_reference front() const { return ptr[0]; }
+  reference back() { return ptr[sz - 1]; }
+  const_reference back() const { return ptr[sz - 1]; }
+
+  pointer data() { return ptr; }
+  const_pointer data() const { return ptr; }
+  iterator begin() { return ptr; }
+  iterator end() { return ptr + sz; }
+  const_iterator begin() const { return ptr; }
+  const_iterator end() const { return ptr + sz; }
+  const_iterator cbegin() const { return ptr; }
+  const_iterator cend() const { return ptr + sz; }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+  size_t size() const { return sz; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return sz == 0; }
+  //! whether the elements still live in the inline buffer
+  bool is_inline() const { return ptr == inline_ptr(); }
+
+  friend bool operator==(const SmallVector& a, const SmallVector& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  friend bool operator!=(const SmallVector& a, const SmallVector& b) {
+    return !(a == b);
+  }
+
+private:
+  T* inline_ptr() { return reinterpret_cast<T*>(storage); }
+  const T* inline_ptr() const { return reinterpret_cast<const T*>(storage); }
+
+  static T* allocate(size_t n) {
+    return static_cast<T*>(::operator new(n * sizeof(T),
+                                          std::align_val_t(alignof(T))));
+  }
+
+  // move the elements into p, which has room for n of them, and adopt it
+  void relocate(T* p, size_t n) {
+    std::uninitialized_move(ptr, ptr + sz, p);
+    std::destroy(ptr, ptr + sz);
+    release();
+    ptr = p;
+    cap = n;
+  }
+
+  void grow(size_t n) {
+    relocate(allocate(n), n);
+  }
+
+  // kept out of line, so the common case stays small when inlined and the
+  // compiler does not follow an inline buffer into the heap path
+  template <typename... Args>
+  [[gnu::noinline]] reference grow_and_emplace(Args&&... args) {
+    // construct before moving, args may refer to one of our elements
+    T* p = allocate(cap * 2);
+    ::new (static_cast<void*>(p + sz)) T(std::forward<Args>(args)...);
+    relocate(p, cap * 2);
+    return ptr[sz++];
+  }
+
+  void release() {
+    if (!is_inline()) {
+      ::operator delete(ptr, std::align_val_t(alignof(T)));
+      ptr = inline_ptr();
+      cap = N;
+    }
+  }
+
+  // expects this to be empty and inline
+  void take(SmallVector&& other) {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), ptr);
+      sz = other.sz;
+      other.clear();
+    } else {
+      ptr = other.ptr;
+      sz = other.sz;
+      cap = other.cap;
+      other.ptr = other.inline_ptr();
+      other.sz = 0;
+      other.cap = N;
+    }
+  }
+
+  alignas(T) unsigned char storage[N * sizeof(T)];
+  T* ptr {inline_ptr()};
+  size_t sz {0};
+  size_t cap {N};
+};
+
+} // namespace eos::common
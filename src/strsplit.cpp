@@ -1,18 +1,34 @@
 #include <string>
 #include <deque>
 #include <vector>
+#include <memory_resource>
+#include <array>
 #include <sstream>
 #include <cstring>
+#include <random>
 #include <sstream>
+#include "alloccounter.hpp"
 #include "lazysplit.hpp"
+#include "smallvector.hpp"
+#include "pathnormalize.hpp"
+#include "pathwalk.hpp"
+#include "intern.hpp"
+#include "pathcache.hpp"
+#include "zipf.hpp"
+#include "pathcorpus.hpp"
 #include "benchmark/benchmark.h"
 #include <iostream>
+#include <map>
 //----------------------------------------------------------------------------
 //! Helper class responsible for spliting the path
 //----------------------------------------------------------------------------
 class PathProcessor
 {
 public:
+  //! inline capacity of the split results, deeper paths spill to the heap
+  static constexpr size_t kTypicalDepth = 16;
+  //! bytes of a path copied to the stack for splitting
+  static constexpr size_t kScratchSize = 1024;
 
   //------------------------------------------------------------------------
   //! Split the path and prepend its elements into a deque.
@@ -20,7 +36,7 @@ public:
   static void insertChunksIntoDeque(std::deque<std::string>& elements,
                                     const std::string& path)
   {
-    std::vector<std::string> tmp;
+    eos::common::SmallVector<std::string, kTypicalDepth> tmp;
     splitPath(tmp, path);
 
     for(auto it = tmp.rbegin(); it != tmp.rend(); it++) {
@@ -30,16 +46,21 @@ public:
 
   //------------------------------------------------------------------------
   //! Split the path and put its elements in a vector, the tokens are
-  //! copied, the buffer is not overwritten
+  //! copied, the buffer is not overwritten. The scratch copy of the path
+  //! lives on the stack up to kScratchSize bytes and on the heap beyond.
+  //!
+  //! @param elements std::vector<std::string>, SmallVector<std::string, N>
+  //!        or any container with the same interface
   //------------------------------------------------------------------------
-  static void splitPath(std::vector<std::string>& elements,
-                        const std::string& path)
+  template <typename C>
+  static void splitPath(C& elements, const std::string& path)
   {
     elements.clear();
-    std::vector<char*> elems;
-    char buffer[path.length() + 1];
-    strcpy(buffer, path.c_str());
-    splitPath(elems, buffer);
+    eos::common::SmallVector<char*, kTypicalDepth> elems;
+    eos::common::SmallVector<char, kScratchSize> buffer(path.c_str(),
+                                                        path.c_str() +
+                                                        path.length() + 1);
+    splitPath(elems, buffer.data());
 
     for (size_t i = 0; i < elems.size(); ++i) {
       elements.push_back(elems[i]);
@@ -49,8 +70,12 @@ public:
   //------------------------------------------------------------------------
   //! Split the path and put its element in a vector, the split is done
   //! in-place and the buffer is overwritten
+  //!
+  //! @param elements std::vector<char*>, SmallVector<char*, N> or any
+  //!        container with the same interface
   //------------------------------------------------------------------------
-  static void splitPath(std::vector<char*>& elements, char* buffer)
+  template <typename C>
+  static void splitPath(C& elements, char* buffer)
   {
     elements.clear();
     elements.reserve(10);
@@ -79,6 +104,18 @@ public:
     }
   }
 
+  //------------------------------------------------------------------------
+  //! Split the path into tokens allocated from a memory resource, eg. a per
+  //! request monotonic_buffer_resource that releases them all at once
+  //------------------------------------------------------------------------
+  static std::pmr::vector<std::pmr::string>
+  splitPath(const std::string& path, std::pmr::memory_resource* mr)
+  {
+    std::pmr::vector<std::pmr::string> elements(mr);
+    splitPath(elements, path);
+    return elements;
+  }
+
   //------------------------------------------------------------------------
   //! Absolute Path sanitizing all '/../' and '/./' entries
   //------------------------------------------------------------------------
@@ -120,12 +157,12 @@ public:
 };
 
 
-std::vector<std::string>
-insertChunksIntoDeque2(std::string_view path, std::string_view delim="/")
+template <typename C = std::vector<std::string>>
+C insertChunksIntoDeque2(std::string_view path, std::string_view delim="/",
+                         C dq = C())
 {
   size_t start_pos = 0;
   size_t end_pos = path.size();
-  std::vector<std::string> dq;
   //dq.reserve(end_pos / 2);
   while (start_pos < path.size() - 1) {
     end_pos = path.find_first_of(delim, start_pos);
@@ -143,6 +180,14 @@ insertChunksIntoDeque2(std::string_view path, std::string_view delim="/")
   return dq;
 }
 
+inline std::pmr::vector<std::pmr::string>
+insertChunksIntoDeque2(std::string_view path, std::pmr::memory_resource* mr,
+                       std::string_view delim="/")
+{
+  return insertChunksIntoDeque2(path, delim,
+                                std::pmr::vector<std::pmr::string>(mr));
+}
+
 inline std::vector<std::string> split(std::string data, std::string token)
 {
   std::vector<std::string> output;
@@ -160,6 +205,43 @@ inline std::vector<std::string> split(std::string data, std::string token)
   return output;
 }
 
+// Same tokens as split() above, but walks a view instead of re-copying the
+// remainder of the string after every token
+inline std::pmr::vector<std::pmr::string>
+split(std::string_view data, std::string_view token,
+      std::pmr::memory_resource* mr)
+{
+  std::pmr::vector<std::pmr::string> output(mr);
+  size_t start = 0;
+  size_t pos = std::string::npos;
+
+  do {
+    pos = data.find(token, start);
+    output.emplace_back(data.substr(start, pos == std::string::npos ?
+                                    pos : pos - start));
+    start = pos + token.size();
+  } while (std::string::npos != pos);
+
+  return output;
+}
+
+template<typename C>
+C StringTokenizer_split(const std::string& str, char delimiter,
+                        std::pmr::memory_resource* mr)
+{
+  std::istringstream iss(str);
+  C container(mr);
+  typename C::value_type part(mr);
+
+  while (std::getline(iss, part, delimiter)) {
+    if (!part.empty()) {
+      container.emplace_back(std::move(part));
+    }
+  }
+
+  return container;
+}
+
 template<typename C>
 C StringTokenizer_split(const std::string& str, char delimiter)
 {
@@ -183,6 +265,7 @@ static void BM_path_processor_dq(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
 
     std::deque<std::string> dq;
@@ -197,12 +280,61 @@ static void BM_path_processor_splitv(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     std::vector<std::string> v;
     PathProcessor::splitPath(v,s);
   }
 }
 
+static void BM_path_processor_splitv_small(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    eos::common::SmallVector<std::string, PathProcessor::kTypicalDepth> v;
+    PathProcessor::splitPath(v,s);
+  }
+}
+
+static void BM_path_processor_splitc(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+  std::string buf;
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    buf.assign(s);
+    std::vector<char*> v;
+    PathProcessor::splitPath(v,buf.data());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+
+static void BM_path_processor_splitc_small(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+  std::string buf;
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    buf.assign(s);
+    eos::common::SmallVector<char*, PathProcessor::kTypicalDepth> v;
+    PathProcessor::splitPath(v,buf.data());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+
 static void BM_split2(benchmark::State& state) {
   auto sz = state.range(0);
   std::string s = "/eos/";
@@ -210,11 +342,80 @@ static void BM_split2(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto dq2 = insertChunksIntoDeque2(s);
   }
 }
 
+// The pmr variants allocate every token of a request from a stack buffer,
+// released in one go when the resource goes out of scope
+static constexpr size_t kPmrBufferSize = 4096;
+
+static void BM_split2_pmr(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::array<std::byte, kPmrBufferSize> buf;
+    std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+    auto dq2 = insertChunksIntoDeque2(s, &mr);
+    benchmark::DoNotOptimize(dq2.data());
+  }
+}
+
+static void BM_path_processor_splitv_pmr(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::array<std::byte, kPmrBufferSize> buf;
+    std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+    auto v = PathProcessor::splitPath(s, &mr);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+
+static void BM_fusex_split_pmr(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::array<std::byte, kPmrBufferSize> buf;
+    std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+    auto v = split(s, "/", &mr);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+
+static void BM_tokenizer_split_pmr(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::array<std::byte, kPmrBufferSize> buf;
+    std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size());
+    auto v = StringTokenizer_split<std::pmr::vector<std::pmr::string>>(s, '/', &mr);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+
 static void BM_fusex_split(benchmark::State& state) {
   auto sz = state.range(0);
   std::string s = "/eos/";
@@ -222,6 +423,7 @@ static void BM_fusex_split(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto v = split(s,"/");
   }
@@ -234,6 +436,7 @@ static void BM_tokenizer_split(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto v = StringTokenizer_split<std::vector<std::string>>(s,'/');
   }
@@ -246,6 +449,7 @@ static void BM_lazy_split_sv(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto parts = eos::common::LazySplit<std::string_view,std::string_view>(s, "/");
 
@@ -263,6 +467,7 @@ static void BM_lazy_split_s(benchmark::State& state) {
     s += "folder" + std::to_string(i) + "/";
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto parts = eos::common::LazySplit<std::string_view,char>(s, '/');
 
@@ -274,6 +479,44 @@ static void BM_lazy_split_s(benchmark::State& state) {
   }
 }
 
+static void BM_lazy_split_sv_small(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    auto parts = eos::common::LazySplit<std::string_view,std::string_view>(s, "/");
+
+    eos::common::SmallVector<std::string_view, PathProcessor::kTypicalDepth> result;
+    for (std::string_view it: parts) {
+      result.emplace_back(it);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+
+static void BM_lazy_split_s_small(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    auto parts = eos::common::LazySplit<std::string_view,char>(s, '/');
+
+    eos::common::SmallVector<std::string_view, PathProcessor::kTypicalDepth> result;
+    for (std::string_view it: parts) {
+      result.emplace_back(it);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+
 static void BM_splitenullc(benchmark::State& state) {
   auto sz = state.range(0);
   std::string s = "/eos/";
@@ -282,6 +525,7 @@ static void BM_splitenullc(benchmark::State& state) {
     s += '\0';
   }
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto parts = eos::common::LazySplit<std::string_view,char>(s, '\0');
 
@@ -303,6 +547,7 @@ static void BM_splitenullsv(benchmark::State& state) {
   std::string nb;
   nb += '\0';
 
+  eos::common::AllocCounters allocs(state);
   for (auto _: state) {
     auto parts = eos::common::LazySplit<std::string_view,std::string_view>(s, nb);
 
@@ -321,6 +566,7 @@ static void BM_CopyDeque(benchmark::State& state) {
   for (int i=0; i< sz; i++) {
     dq.emplace_back("folder"+std::to_string(sz));
   }
+  eos::common::AllocCounters allocs(state);
   for (auto _ : state) {
     auto dq2 = dq;
   }
@@ -332,19 +578,550 @@ static void BM_MoveDeque(benchmark::State& state) {
   for (int i=0; i< sz; i++) {
     dq.emplace_back("folder"+std::to_string(sz));
   }
+  eos::common::AllocCounters allocs(state);
   for (auto _ : state) {
     auto dq2 = std::move(dq);
   }
 }
+static void BM_pathwalk_dq(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    eos::common::PathWalk pw(s);
+    benchmark::DoNotOptimize(pw.size());
+  }
+}
+
+static void BM_CopyPathWalk(benchmark::State& state) {
+  auto sz = state.range(0);
+  eos::common::PathWalk pw;
+  for (int i=0; i< sz; i++) {
+    pw.push_front("folder"+std::to_string(sz));
+  }
+  eos::common::AllocCounters allocs(state);
+  for (auto _ : state) {
+    auto pw2 = pw;
+    benchmark::DoNotOptimize(pw2.size());
+  }
+}
+
+// Walk a path that hits a symlink after two components, the target is
+// prepended to the remaining components and walked through
+static void BM_path_processor_symlink(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/link/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::deque<std::string> dq;
+    PathProcessor::insertChunksIntoDeque(dq, s);
+    dq.pop_front();
+    dq.pop_front();
+    PathProcessor::insertChunksIntoDeque(dq, "/eos/target/user/dir");
+    while (!dq.empty()) {
+      benchmark::DoNotOptimize(dq.front());
+      dq.pop_front();
+    }
+  }
+}
+
+static void BM_pathwalk_symlink(benchmark::State& state) {
+  auto sz = state.range(0);
+  std::string s = "/eos/link/";
+  for (auto i = 0; i< sz;i++) {
+    s += "folder" + std::to_string(i) + "/";
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    eos::common::PathWalk pw(s);
+    pw.pop_front();
+    pw.pop_front();
+    pw.push_front("/eos/target/user/dir");
+    while (!pw.empty()) {
+      benchmark::DoNotOptimize(pw.front());
+      pw.pop_front();
+    }
+  }
+}
+
+// Paths with namespace like component reuse, a few instances and a few hundred
+// users, each with the same folderN/fileN names underneath
+static std::vector<std::string> MakeReusePaths(size_t n)
+{
+  static const char* instances[] = {"atlas", "cms", "lhcb", "alice"};
+  std::mt19937 gen(42);
+  std::vector<std::string> paths;
+  paths.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    auto user = gen() % 512;
+    std::string p = "/eos/";
+    p += instances[gen() % 4];
+    p += "/user/";
+    p += static_cast<char>('a' + user % 26);
+    p += "/user" + std::to_string(user);
+    p += "/folder" + std::to_string(gen() % 16);
+    p += "/file" + std::to_string(gen() % 64);
+    paths.emplace_back(std::move(p));
+  }
+  return paths;
+}
+
+static size_t HeapBytes(const std::vector<std::string>& v)
+{
+  size_t bytes = v.capacity() * sizeof(std::string);
+  for (const auto& s: v) {
+    // anything beyond the SSO buffer lives on the heap
+    if (s.capacity() > 15) {
+      bytes += s.capacity() + 1;
+    }
+  }
+  return bytes;
+}
+
+static void BM_split_strings_reuse(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  std::vector<std::vector<std::string>> split(paths.size());
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (size_t i = 0; i < paths.size(); i++) {
+      split[i] = insertChunksIntoDeque2(paths[i]);
+    }
+  }
+
+  size_t bytes = 0;
+  for (const auto& v: split) {
+    bytes += HeapBytes(v);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+  state.counters["bytes_per_path"] = double(bytes) / paths.size();
+}
+
+static void BM_intern_split_reuse(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  eos::common::StringInterner interner;
+  std::vector<eos::common::InternedPath> split(paths.size());
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (size_t i = 0; i < paths.size(); i++) {
+      eos::common::InternSplit(interner, paths[i], split[i]);
+    }
+  }
+
+  size_t bytes = interner.memory_usage();
+  for (const auto& p: split) {
+    bytes += p.ids.capacity() * sizeof(uint32_t);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+  state.counters["bytes_per_path"] = double(bytes) / paths.size();
+  state.counters["components"] = interner.size();
+}
+
+// All threads intern the same corpus into one shared table
+static void BM_intern_split_shared(benchmark::State& state) {
+  static std::unique_ptr<eos::common::StringInterner> interner;
+  static std::vector<std::string> paths;
+  if (state.thread_index() == 0) {
+    interner = std::make_unique<eos::common::StringInterner>();
+    paths = MakeReusePaths(state.range(0));
+  }
+
+  eos::common::InternedPath split;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (const auto& p: paths) {
+      eos::common::InternSplit(*interner, p, split);
+      benchmark::DoNotOptimize(split.ids.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+
+static void BM_compare_string_paths(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  std::vector<std::vector<std::string>> split;
+  for (const auto& p: paths) {
+    split.emplace_back(insertChunksIntoDeque2(p));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    size_t equal = 0;
+    for (size_t i = 1; i < split.size(); i++) {
+      equal += split[i] == split[i - 1];
+    }
+    benchmark::DoNotOptimize(equal);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+
+static void BM_compare_interned_paths(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  eos::common::StringInterner interner;
+  std::vector<eos::common::InternedPath> split(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    eos::common::InternSplit(interner, paths[i], split[i]);
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    size_t equal = 0;
+    for (size_t i = 1; i < split.size(); i++) {
+      equal += split[i] == split[i - 1];
+    }
+    benchmark::DoNotOptimize(equal);
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+
+static void BM_hash_string_paths(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  std::vector<std::vector<std::string>> split;
+  for (const auto& p: paths) {
+    split.emplace_back(insertChunksIntoDeque2(p));
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (const auto& v: split) {
+      size_t h = 0;
+      for (const auto& c: v) {
+        h = h * 31 + std::hash<std::string>{}(c);
+      }
+      benchmark::DoNotOptimize(h);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+
+static void BM_hash_interned_paths(benchmark::State& state) {
+  auto paths = MakeReusePaths(state.range(0));
+  eos::common::StringInterner interner;
+  std::vector<eos::common::InternedPath> split(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    eos::common::InternSplit(interner, paths[i], split[i]);
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (const auto& p: split) {
+      benchmark::DoNotOptimize(eos::common::InternedPathHash{}(p));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+
+// Corpus for the path cache, distinct paths of which a third are dirty
+static std::vector<std::string> MakeCachePaths(size_t n)
+{
+  std::vector<std::string> paths;
+  paths.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    std::string p = "/eos/user/u" + std::to_string(i % 997) + "/";
+    p += (i % 3 == 0) ? "./tmp/../" : "";
+    p += "folder" + std::to_string(i) + "/file" + std::to_string(i);
+    paths.emplace_back(std::move(p));
+  }
+  return paths;
+}
+
+static void BM_split_uncached_zipf(benchmark::State& state) {
+  static std::vector<std::string> paths;
+  if (state.thread_index() == 0) {
+    paths = MakeCachePaths(state.range(0));
+  }
+
+  std::mt19937_64 gen(state.thread_index());
+  ZipfDistribution zipf(state.range(0));
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    std::string p = paths[zipf(gen)];
+    PathProcessor::absPath(p);
+    std::vector<std::string> v;
+    PathProcessor::splitPath(v, p);
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// range(1) is the cache budget in KiB
+static void BM_split_cached_zipf(benchmark::State& state) {
+  static std::vector<std::string> paths;
+  static std::unique_ptr<eos::common::PathCache> cache;
+  if (state.thread_index() == 0) {
+    paths = MakeCachePaths(state.range(0));
+    cache = std::make_unique<eos::common::PathCache>(state.range(1) << 10);
+  }
+
+  std::mt19937_64 gen(state.thread_index());
+  ZipfDistribution zipf(state.range(0));
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    benchmark::DoNotOptimize(cache->get(paths[zipf(gen)]));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    auto stats = cache->stats();
+    state.counters["hit_ratio"] = double(stats.hits) / (stats.hits + stats.misses);
+    state.counters["evictions"] = stats.evictions;
+    state.counters["cache_bytes"] = stats.bytes;
+  }
+}
+
+//----------------------------------------------------------------------------
+// Corpus driven benchmarks: every splitter and normalizer runs over the same
+// path lists, the synthetic ones from GeneratePathCorpus and optionally a
+// real one given with --path_corpus=<file>, one path per line
+//----------------------------------------------------------------------------
+using PathFn = void (*)(const std::string&);
+
+static const std::pair<const char*, PathFn> kCorpusSplitters[] = {
+  {"path_processor_splitv", [](const std::string& p) {
+    std::vector<std::string> v;
+    PathProcessor::splitPath(v, p);
+    benchmark::DoNotOptimize(v.data());
+  }},
+  {"path_processor_splitv_small", [](const std::string& p) {
+    eos::common::SmallVector<std::string, PathProcessor::kTypicalDepth> v;
+    PathProcessor::splitPath(v, p);
+    benchmark::DoNotOptimize(v.data());
+  }},
+  {"path_processor_dq", [](const std::string& p) {
+    std::deque<std::string> dq;
+    PathProcessor::insertChunksIntoDeque(dq, p);
+    benchmark::DoNotOptimize(dq.size());
+  }},
+  {"split2", [](const std::string& p) {
+    benchmark::DoNotOptimize(insertChunksIntoDeque2(p));
+  }},
+  {"fusex_split", [](const std::string& p) {
+    benchmark::DoNotOptimize(split(p, "/"));
+  }},
+  {"tokenizer_split", [](const std::string& p) {
+    benchmark::DoNotOptimize(StringTokenizer_split<std::vector<std::string>>(p, '/'));
+  }},
+  {"lazy_split_sv", [](const std::string& p) {
+    std::vector<std::string_view> result;
+    for (std::string_view it: eos::common::LazySplit<std::string_view,std::string_view>(p, "/")) {
+      result.emplace_back(it);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }},
+  {"lazy_split_s", [](const std::string& p) {
+    std::vector<std::string_view> result;
+    for (std::string_view it: eos::common::LazySplit<std::string_view,char>(p, '/')) {
+      result.emplace_back(it);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }},
+  {"lazy_split_s_small", [](const std::string& p) {
+    eos::common::SmallVector<std::string_view, PathProcessor::kTypicalDepth> result;
+    for (std::string_view it: eos::common::LazySplit<std::string_view,char>(p, '/')) {
+      result.emplace_back(it);
+    }
+    benchmark::DoNotOptimize(result.data());
+  }},
+  {"pathwalk", [](const std::string& p) {
+    eos::common::PathWalk pw(p);
+    benchmark::DoNotOptimize(pw.size());
+  }},
+  {"absPath", [](const std::string& p) {
+    std::string s = p;
+    PathProcessor::absPath(s);
+    benchmark::DoNotOptimize(s.data());
+  }},
+  {"NormalizePath", [](const std::string& p) {
+    std::string s = p;
+    eos::common::NormalizePath(s);
+    benchmark::DoNotOptimize(s.data());
+  }},
+};
+
+static void BM_corpus(benchmark::State& state,
+                      const std::vector<std::string>* corpus, PathFn fn) {
+  size_t bytes = 0;
+  for (const auto& p: *corpus) {
+    bytes += p.size();
+  }
+
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    for (const auto& p: *corpus) {
+      fn(p);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * corpus->size());
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+static std::map<std::string, std::vector<std::string>>& Corpora()
+{
+  static std::map<std::string, std::vector<std::string>> corpora;
+  return corpora;
+}
+
+static void RegisterCorpusBenchmarks(const std::string& corpus_file)
+{
+  auto& corpora = Corpora();
+  PathCorpusConfig cfg;
+  corpora["clean"] = GeneratePathCorpus(cfg);
+  cfg.dirty_ratio = 0.3;
+  corpora["dirty"] = GeneratePathCorpus(cfg);
+  cfg.dirty_ratio = 0.0;
+  cfg.utf8_ratio = 0.3;
+  corpora["utf8"] = GeneratePathCorpus(cfg);
+  cfg.utf8_ratio = 0.0;
+  cfg.min_depth = 16;
+  cfg.max_depth = 48;
+  cfg.name_len_median = 24;
+  corpora["deep_long"] = GeneratePathCorpus(cfg);
+
+  if (!corpus_file.empty()) {
+    auto paths = LoadPathCorpus(corpus_file);
+    if (paths.empty()) {
+      std::cerr << "no paths loaded from " << corpus_file << std::endl;
+    } else {
+      corpora["file"] = std::move(paths);
+    }
+  }
+
+  for (const auto& [name, paths]: corpora) {
+    for (const auto& [fn_name, fn]: kCorpusSplitters) {
+      benchmark::RegisterBenchmark(("BM_corpus_" + std::string(fn_name) + "/" +
+                                    name).c_str(), BM_corpus, &paths, fn);
+    }
+  }
+}
+
+// Paths for the normalization benchmarks, a clean path is already canonical,
+// a dirty one has every component followed by one of '//', '/./' or a
+// 'tmp/../' detour that the normalizer has to undo
+static std::string MakeNormPath(int64_t sz, bool dirty)
+{
+  static const char* detours[] = {"/", "/./", "/tmp/../"};
+  std::string s = "/eos";
+  for (auto i = 0; i < sz; i++) {
+    s += dirty ? detours[i % 3] : "/";
+    s += "folder" + std::to_string(i);
+  }
+  return s;
+}
+
+static void BM_absPath_clean(benchmark::State& state) {
+  std::string s = MakeNormPath(state.range(0), false);
+  std::string p;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    p.assign(s);
+    PathProcessor::absPath(p);
+    benchmark::DoNotOptimize(p.data());
+  }
+}
+
+static void BM_NormalizePath_clean(benchmark::State& state) {
+  std::string s = MakeNormPath(state.range(0), false);
+  std::string p;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    p.assign(s);
+    eos::common::NormalizePath(p);
+    benchmark::DoNotOptimize(p.data());
+  }
+}
+
+static void BM_absPath_dirty(benchmark::State& state) {
+  std::string s = MakeNormPath(state.range(0), true);
+  std::string p;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    p.assign(s);
+    PathProcessor::absPath(p);
+    benchmark::DoNotOptimize(p.data());
+  }
+}
+
+static void BM_NormalizePath_dirty(benchmark::State& state) {
+  std::string s = MakeNormPath(state.range(0), true);
+  std::string p;
+  eos::common::AllocCounters allocs(state);
+  for (auto _: state) {
+    p.assign(s);
+    eos::common::NormalizePath(p);
+    benchmark::DoNotOptimize(p.data());
+  }
+}
 
 
 BENCHMARK(BM_path_processor_dq)->DenseRange(0,32,4);
+BENCHMARK(BM_pathwalk_dq)->DenseRange(0,32,4);
+BENCHMARK(BM_path_processor_symlink)->DenseRange(0,32,4);
+BENCHMARK(BM_pathwalk_symlink)->DenseRange(0,32,4);
+BENCHMARK(BM_CopyDeque)->DenseRange(0,32,4);
+BENCHMARK(BM_CopyPathWalk)->DenseRange(0,32,4);
 BENCHMARK(BM_path_processor_splitv)->DenseRange(0,32,4);
+BENCHMARK(BM_path_processor_splitv_small)->DenseRange(0,32,4);
+BENCHMARK(BM_path_processor_splitc)->DenseRange(0,32,4);
+BENCHMARK(BM_path_processor_splitc_small)->DenseRange(0,32,4);
+BENCHMARK(BM_path_processor_splitv_pmr)->DenseRange(0,32,4);
+BENCHMARK(BM_split2)->DenseRange(0,32,4);
+BENCHMARK(BM_split2_pmr)->DenseRange(0,32,4);
 BENCHMARK(BM_fusex_split)->DenseRange(0,32,4);
+BENCHMARK(BM_fusex_split_pmr)->DenseRange(0,32,4);
 BENCHMARK(BM_tokenizer_split)->DenseRange(0,32,4);
+BENCHMARK(BM_tokenizer_split_pmr)->DenseRange(0,32,4);
 BENCHMARK(BM_lazy_split_sv)->DenseRange(0,32,4);
 BENCHMARK(BM_lazy_split_s)->DenseRange(0,32,4);
+BENCHMARK(BM_lazy_split_sv_small)->DenseRange(0,32,4);
+BENCHMARK(BM_lazy_split_s_small)->DenseRange(0,32,4);
 BENCHMARK(BM_splitenullc)->DenseRange(0,32,4);
 BENCHMARK(BM_splitenullsv)->DenseRange(0,32,4);
+BENCHMARK(BM_absPath_clean)->DenseRange(0,32,4);
+BENCHMARK(BM_NormalizePath_clean)->DenseRange(0,32,4);
+BENCHMARK(BM_absPath_dirty)->DenseRange(0,32,4);
+BENCHMARK(BM_NormalizePath_dirty)->DenseRange(0,32,4);
+// deep paths, past the normalizer's inline offset stack
+BENCHMARK(BM_absPath_dirty)->RangeMultiplier(4)->Range(64,1024);
+BENCHMARK(BM_NormalizePath_dirty)->RangeMultiplier(4)->Range(64,1024);
+BENCHMARK(BM_split_strings_reuse)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_intern_split_reuse)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_intern_split_shared)->Arg(1<<12)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK(BM_compare_string_paths)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_compare_interned_paths)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_hash_string_paths)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_hash_interned_paths)->RangeMultiplier(8)->Range(1<<10,1<<16);
+BENCHMARK(BM_split_uncached_zipf)->Arg(1<<16)->ThreadRange(1,16)->UseRealTime();
+BENCHMARK(BM_split_cached_zipf)->Args({1<<16, 1<<12})->Args({1<<16, 1<<15})
+                               ->ThreadRange(1,16)->UseRealTime();
 
-BENCHMARK_MAIN();
+int main(int argc, char** argv)
+{
+  std::string corpus_file;
+  int nargs = 0;
+  for (int i = 0; i < argc; i++) {
+    std::string_view arg = argv[i];
+    if (arg.substr(0, 14) == "--path_corpus=") {
+      corpus_file = arg.substr(14);
+    } else {
+      argv[nargs++] = argv[i];
+    }
+  }
+  argc = nargs;
+
+  RegisterCorpusBenchmarks(corpus_file);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  eos::common::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,534 @@
+// ----------------------------------------------------------------------
+// File: swissmap.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Open addressing string to string hash map in the style of the Swiss
+//! tables. Every slot has a control byte holding either a 7 bit tag of the
+//! key hash or an empty/deleted marker, a probe compares the tags of a group
+//! of 16 slots at once (with SSE2 where available) and only looks at the
+//! slots whose tag matches. Those are checked against the 32 bit hash and
+//! the key length cached next to the control bytes before the key itself is
+//! compared, so a mismatch rarely touches the key.
+//!
+//! Meant as a drop-in for std::map<std::string, std::string> where the order
+//! does not matter: lookups take a std::string_view, or the key in two
+//! segments, so probing never builds a std::string. Iterators and references
+//! are invalidated by insertions that grow the table, erasing only
+//! invalidates the erased element.
+//----------------------------------------------------------------------------
+class SwissStringMap {
+  template <bool is_const>
+  class Iterator;
+
+public:
+  using key_type = std::string;
+  using mapped_type = std::string;
+  using value_type = std::pair<const std::string, std::string>;
+  using size_type = size_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  //! keys resolved together by find_batch()
+  static constexpr size_t kBatchGroup = 16;
+
+  SwissStringMap() = default;
+
+  SwissStringMap(const SwissStringMap& other) {
+    reserve(other.size());
+    for (const auto& kv: other) {
+      emplace(kv.first, kv.second);
+    }
+  }
+
+  SwissStringMap(SwissStringMap&& other) noexcept {
+    swap(other);
+  }
+
+  SwissStringMap& operator=(SwissStringMap other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  ~SwissStringMap() {
+    destroy();
+  }
+
+  void swap(SwissStringMap& other) noexcept {
+    std::swap(ctrl, other.ctrl);
+    std::swap(meta, other.meta);
+    std::swap(slots, other.slots);
+    std::swap(cap, other.cap);
+    std::swap(sz, other.sz);
+    std::swap(growth_left, other.growth_left);
+  }
+
+  iterator find(std::string_view key) {
+    return {this, find_index(key, {}, hash(key, {}))};
+  }
+
+  const_iterator find(std::string_view key) const {
+    return {this, find_index(key, {}, hash(key, {}))};
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup the key prefix + suffix, without concatenating them
+  //--------------------------------------------------------------------------
+  const_iterator find(std::string_view prefix, std::string_view suffix) const {
+    return {this, find_index(prefix, suffix, hash(prefix, suffix))};
+  }
+
+  //--------------------------------------------------------------------------
+  //! Lookup the keys in [first, last), writing the value of each, or
+  //! std::nullopt, to out. The keys are taken kBatchGroup at a time: all of
+  //! them hashed with their control bytes prefetched, then the slot of the
+  //! first tag match prefetched, then resolved, so the cache misses of a
+  //! group overlap instead of forming one dependent chain per key.
+  //--------------------------------------------------------------------------
+  template <typename KeyIt, typename OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const {
+    uint32_t h[kBatchGroup];
+    while (first != last) {
+      size_t n = 0;
+      for (auto it = first; it != last && n < kBatchGroup; ++it, ++n) {
+        h[n] = hash(*it, {});
+        if (cap) {
+          auto g = first_group(h[n]);
+          __builtin_prefetch(ctrl + g);
+          __builtin_prefetch(meta + g);
+        }
+      }
+      // reading the control bytes of a lone key only delays its own lookup
+      for (size_t i = 0; i < n && n > 1 && cap; i++) {
+        auto g = first_group(h[i]);
+        if (auto m = Group(ctrl + g).match(h[i] & 0x7f)) {
+          __builtin_prefetch(slots + g + __builtin_ctz(m));
+        }
+      }
+      for (size_t i = 0; i < n; i++, ++first, ++out) {
+        std::string_view key = *first;
+        if (auto idx = find_index(key, {}, h[i]); idx != cap) {
+          *out = std::string_view(slots[idx].second);
+        } else {
+          *out = std::nullopt;
+        }
+      }
+    }
+    return out;
+  }
+
+  size_type count(std::string_view key) const {
+    return find(key) != end();
+  }
+
+  bool contains(std::string_view key) const {
+    return find(key) != end();
+  }
+
+  //--------------------------------------------------------------------------
+  //! Insert key if absent, with the value built from args
+  //!
+  //! @return the element of key and whether it was inserted
+  //--------------------------------------------------------------------------
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    std::string_view k(key);
+    auto h = hash(k, {});
+    if (auto i = find_index(k, {}, h); i != cap) {
+      return {{this, i}, false};
+    }
+
+    auto i = prepare_insert(h);
+    ::new (static_cast<void*>(slots + i))
+      value_type(std::piecewise_construct,
+                 std::forward_as_tuple(std::forward<K>(key)),
+                 std::forward_as_tuple(std::forward<Args>(args)...));
+    set_full(i, h, k.size());
+    return {{this, i}, true};
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> emplace(K&& key, V&& value) {
+    return try_emplace(std::forward<K>(key), std::forward<V>(value));
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> emplace(std::pair<K, V>&& kv) {
+    return try_emplace(std::move(kv.first), std::move(kv.second));
+  }
+
+  template <typename K, typename V>
+  std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+    auto res = try_emplace(std::forward<K>(key), std::forward<V>(value));
+    if (!res.second) {
+      res.first->second = std::forward<V>(value);
+    }
+    return res;
+  }
+
+  template <typename K>
+  std::string& operator[](K&& key) {
+    return try_emplace(std::forward<K>(key)).first->second;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Erase the element at pos
+  //!
+  //! @return the iterator following pos
+  //--------------------------------------------------------------------------
+  iterator erase(const_iterator pos) {
+    erase_index(pos.index);
+    return ++iterator(this, pos.index);
+  }
+
+  iterator erase(iterator pos) {
+    return erase(const_iterator(pos));
+  }
+
+  size_type erase(std::string_view key) {
+    auto i = find_index(key, {}, hash(key, {}));
+    if (i == cap) {
+      return 0;
+    }
+    erase_index(i);
+    return 1;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Make room for n elements without growing
+  //--------------------------------------------------------------------------
+  void reserve(size_type n) {
+    size_t c = kGroupSize;
+    while (max_load(c) < n) {
+      c *= 2;
+    }
+    if (c > cap) {
+      rehash(c);
+    }
+  }
+
+  void clear() {
+    destroy();
+    ctrl = nullptr;
+    meta = nullptr;
+    slots = nullptr;
+    cap = sz = growth_left = 0;
+  }
+
+  iterator begin() { return ++iterator(this, npos); }
+  iterator end() { return {this, cap}; }
+  const_iterator begin() const { return ++const_iterator(this, npos); }
+  const_iterator end() const { return {this, cap}; }
+
+  size_type size() const { return sz; }
+  bool empty() const { return sz == 0; }
+  size_type capacity() const { return cap; }
+
+  //! heap bytes held by the table, including the heap part of the strings
+  size_t memory_usage() const {
+    size_t bytes = cap * (1 + sizeof(Meta) + sizeof(value_type));
+    for (const auto& kv: *this) {
+      bytes += heap_bytes(kv.first) + heap_bytes(kv.second);
+    }
+    return bytes;
+  }
+
+  //--------------------------------------------------------------------------
+  //! 32 bit FNV-1a of the key prefix + suffix, the same for any split. The
+  //! low 7 bits are the tag, the rest picks the first group.
+  //--------------------------------------------------------------------------
+  static uint32_t hash(std::string_view prefix, std::string_view suffix) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : prefix) {
+      h = (h ^ c) * 1099511628211ull;
+    }
+    for (unsigned char c : suffix) {
+      h = (h ^ c) * 1099511628211ull;
+    }
+    return h ^ (h >> 32);
+  }
+
+private:
+  static constexpr size_t kGroupSize = 16;
+  static constexpr size_t npos = SIZE_MAX;
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  struct Meta {
+    uint32_t hash;
+    uint32_t len;
+  };
+
+  //--------------------------------------------------------------------------
+  //! The control bytes of 16 slots, the match functions return a bit mask of
+  //! the slots in the group. Full slots hold a tag in [0, 127], so the empty
+  //! and deleted markers are the ones with the sign bit set.
+  //--------------------------------------------------------------------------
+  struct Group {
+#if defined(__SSE2__)
+    explicit Group(const int8_t* p) :
+      v(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    uint32_t match(int8_t tag) const {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(tag)));
+    }
+
+    uint32_t match_empty_or_deleted() const {
+      return _mm_movemask_epi8(v);
+    }
+
+    __m128i v;
+#else
+    explicit Group(const int8_t* p) : p(p) {}
+
+    uint32_t match(int8_t tag) const {
+      uint32_t m = 0;
+      for (size_t i = 0; i < kGroupSize; i++) {
+        m |= uint32_t(p[i] == tag) << i;
+      }
+      return m;
+    }
+
+    uint32_t match_empty_or_deleted() const {
+      uint32_t m = 0;
+      for (size_t i = 0; i < kGroupSize; i++) {
+        m |= uint32_t(p[i] < 0) << i;
+      }
+      return m;
+    }
+
+    const int8_t* p;
+#endif
+
+    uint32_t match_empty() const { return match(kEmpty); }
+  };
+
+  template <bool is_const>
+  class Iterator {
+    using map_type = std::conditional_t<is_const, const SwissStringMap,
+                                        SwissStringMap>;
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SwissStringMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<is_const, const value_type&,
+                                         value_type&>;
+    using pointer = std::conditional_t<is_const, const value_type*,
+                                       value_type*>;
+
+    Iterator() = default;
+    Iterator(map_type* m, size_t index) : m(m), index(index) {}
+
+    // iterator to const_iterator
+    template <bool c = is_const, typename = std::enable_if_t<c>>
+    Iterator(const Iterator<false>& other) : m(other.m), index(other.index) {}
+
+    reference operator*() const { return m->slots[index]; }
+    pointer operator->() const { return m->slots + index; }
+
+    Iterator& operator++() {
+      // npos + 1 wraps to 0 for begin()
+      while (++index < m->cap && m->ctrl[index] < 0) {}
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.index == b.index;
+    }
+
+    friend bool operator!=(const Iterator& a, const Iterator& b) {
+      return a.index != b.index;
+    }
+
+  private:
+    friend class SwissStringMap;
+    friend class Iterator<!is_const>;
+    map_type* m {nullptr};
+    size_t index {0};
+  };
+
+  // index of the first slot of the group a probe for h starts at
+  size_t first_group(uint32_t h) const {
+    return ((h >> 7) & (cap / kGroupSize - 1)) * kGroupSize;
+  }
+
+  static size_t max_load(size_t c) {
+    return c - c / 8;
+  }
+
+  static size_t heap_bytes(const std::string& s) {
+    // still in the inline buffer
+    return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+  }
+
+  // slot of prefix + suffix, or cap if absent; groups are visited in
+  // triangular order which covers all of them for a power of 2 count
+  size_t find_index(std::string_view prefix, std::string_view suffix,
+                    uint32_t h) const {
+    if (cap == 0) {
+      return cap;
+    }
+
+    size_t len = prefix.size() + suffix.size();
+    size_t mask = cap / kGroupSize - 1;
+    size_t g = (h >> 7) & mask;
+    for (size_t step = 1;; step++) {
+      Group group(ctrl + g * kGroupSize);
+      for (auto m = group.match(h & 0x7f); m; m &= m - 1) {
+        size_t i = g * kGroupSize + __builtin_ctz(m);
+        if (meta[i].hash == h && meta[i].len == len) {
+          std::string_view key = slots[i].first;
+          if (key.substr(0, prefix.size()) == prefix &&
+              key.substr(prefix.size()) == suffix) {
+            return i;
+          }
+        }
+      }
+      if (group.match_empty()) {
+        return cap;
+      }
+      g = (g + step) & mask;
+    }
+  }
+
+  size_t find_free(uint32_t h) const {
+    size_t mask = cap / kGroupSize - 1;
+    size_t g = (h >> 7) & mask;
+    for (size_t step = 1;; step++) {
+      if (auto m = Group(ctrl + g * kGroupSize).match_empty_or_deleted()) {
+        return g * kGroupSize + __builtin_ctz(m);
+      }
+      g = (g + step) & mask;
+    }
+  }
+
+  // free slot for a new key of hash h, growing the table if needed
+  size_t prepare_insert(uint32_t h) {
+    auto i = cap ? find_free(h) : 0;
+    if (cap == 0 || (growth_left == 0 && ctrl[i] == kEmpty)) {
+      // drop the tombstones in place if they are what fills the table
+      rehash(cap && sz < max_load(cap) / 2 ? cap : std::max(cap * 2,
+                                                            kGroupSize));
+      i = find_free(h);
+    }
+    if (ctrl[i] == kEmpty) {
+      --growth_left;
+    }
+    return i;
+  }
+
+  void set_full(size_t i, uint32_t h, size_t len) {
+    ctrl[i] = h & 0x7f;
+    meta[i] = {h, static_cast<uint32_t>(len)};
+    ++sz;
+  }
+
+  void erase_index(size_t i) {
+    slots[i].~value_type();
+    --sz;
+    // a group that still has an empty slot never had probes pass over it,
+    // so the slot can go back to empty instead of leaving a tombstone
+    size_t g = i / kGroupSize * kGroupSize;
+    if (Group(ctrl + g).match_empty()) {
+      ctrl[i] = kEmpty;
+      ++growth_left;
+    } else {
+      ctrl[i] = kDeleted;
+    }
+  }
+
+  void rehash(size_t new_cap) {
+    SwissStringMap next;
+    next.ctrl = static_cast<int8_t*>(::operator new(new_cap));
+    std::fill(next.ctrl, next.ctrl + new_cap, kEmpty);
+    next.meta = static_cast<Meta*>(::operator new(new_cap * sizeof(Meta)));
+    next.slots = static_cast<value_type*>(
+                   ::operator new(new_cap * sizeof(value_type),
+                                  std::align_val_t(alignof(value_type))));
+    next.cap = new_cap;
+    next.growth_left = max_load(new_cap);
+
+    for (size_t i = 0; i < cap; i++) {
+      if (ctrl[i] < 0) {
+        continue;
+      }
+      auto j = next.find_free(meta[i].hash);
+      // the old element is destroyed right after, so its key can be moved
+      // from despite being const
+      ::new (static_cast<void*>(next.slots + j))
+        value_type(std::move(const_cast<std::string&>(slots[i].first)),
+                   std::move(slots[i].second));
+      next.set_full(j, meta[i].hash, meta[i].len);
+      --next.growth_left;
+    }
+    swap(next);
+  }
+
+  void destroy() {
+    if (!ctrl) {
+      return;
+    }
+    for (size_t i = 0; i < cap; i++) {
+      if (ctrl[i] >= 0) {
+        slots[i].~value_type();
+      }
+    }
+    ::operator delete(ctrl);
+    ::operator delete(meta);
+    ::operator delete(slots, std::align_val_t(alignof(value_type)));
+  }
+
+  int8_t* ctrl {nullptr};
+  Meta* meta {nullptr};
+  value_type* slots {nullptr};
+  size_t cap {0};
+  size_t sz {0};
+  size_t growth_left {0};
+};
+
+} // namespace eos::common
@@ -0,0 +1,301 @@
+// ----------------------------------------------------------------------
+// File: versionedpolicy.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "flatpolicymap.hpp"
+#include "lrucache.hpp"
+#include "policykeycache.hpp"
+#include "rcupolicystore.hpp"
+#include "resolvedpolicy.hpp"
+#include "smallvector.hpp"
+
+namespace eos::common {
+
+//----------------------------------------------------------------------------
+//! Change counters for a policy store: a global generation and one per
+//! bucket of keys, keys being hashed to buckets. Bumped after the store
+//! change is published, so a reader that sees a bumped counter also sees
+//! the change.
+//----------------------------------------------------------------------------
+class PolicyGenerations {
+public:
+  static constexpr size_t kBuckets = 1 << 16;
+
+  void bump(std::string_view key) {
+    buckets[bucket_of(key, {})].fetch_add(1, std::memory_order_release);
+    global_gen.fetch_add(1, std::memory_order_release);
+  }
+
+  uint64_t global() const {
+    return global_gen.load(std::memory_order_acquire);
+  }
+
+  uint64_t bucket(size_t idx) const {
+    return buckets[idx].load(std::memory_order_acquire);
+  }
+
+  //! bucket of the key prefix + suffix
+  static uint32_t bucket_of(std::string_view prefix, std::string_view suffix) {
+    return FlatPolicyMap::hash(prefix, suffix) & (kBuckets - 1);
+  }
+
+private:
+  std::atomic<uint64_t> global_gen {0};
+  std::array<std::atomic<uint64_t>, kBuckets> buckets {};
+};
+
+//----------------------------------------------------------------------------
+//! RcuPolicyStore that bumps the generation of every key it actually
+//! changes, assigning a key its current value is not a change
+//----------------------------------------------------------------------------
+class VersionedPolicyStore {
+public:
+  //--------------------------------------------------------------------------
+  //! The modifications of one update(), recording the changed keys
+  //--------------------------------------------------------------------------
+  class Batch {
+  public:
+    void insert_or_assign(std::string_view key, std::string_view value) {
+      if (auto old = m.find(key); old && *old == value) {
+        return;
+      }
+      m.insert_or_assign(key, value);
+      changed.emplace_back(key);
+    }
+
+    template <typename Pred>
+    size_t erase_if(Pred pred) {
+      return m.erase_if([&](const FlatPolicyMap::value_type& kv) {
+        if (pred(kv)) {
+          changed.emplace_back(kv.first);
+          return true;
+        }
+        return false;
+      });
+    }
+
+  private:
+    friend class VersionedPolicyStore;
+    Batch(FlatPolicyMap& m, std::vector<std::string>& changed) :
+      m(m), changed(changed) {}
+
+    FlatPolicyMap& m;
+    std::vector<std::string>& changed;
+  };
+
+  template <typename F>
+  decltype(auto) read(F&& f) const {
+    return store.read(std::forward<F>(f));
+  }
+
+  //! see RcuPolicyStore::find_batch
+  template <typename KeyIt, typename OutIt>
+  OutIt find_batch(KeyIt first, KeyIt last, OutIt out) const {
+    return store.find_batch(first, last, out);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Apply f(Batch&) as a single snapshot, see RcuPolicyStore::update
+  //--------------------------------------------------------------------------
+  template <typename F>
+  void update(F&& f) {
+    std::vector<std::string> changed;
+    store.update([&](FlatPolicyMap& m) {
+      Batch batch(m, changed);
+      f(batch);
+    });
+
+    for (const auto& key: changed) {
+      gens.bump(key);
+    }
+  }
+
+  void insert_or_assign(std::string_view key, std::string_view value) {
+    update([&](Batch& b) { b.insert_or_assign(key, value); });
+  }
+
+  template <typename Pred>
+  size_t erase_if(Pred pred) {
+    size_t n = 0;
+    update([&](Batch& b) { n = b.erase_if(pred); });
+    return n;
+  }
+
+  const PolicyGenerations& generations() const { return gens; }
+
+private:
+  RcuPolicyStore store;
+  PolicyGenerations gens;
+};
+
+//----------------------------------------------------------------------------
+//! A ResolvedPolicy owning its values, along with the generations of every
+//! key it was resolved from
+//----------------------------------------------------------------------------
+class CachedPolicy {
+public:
+  ResolvedPolicy view() const {
+    ResolvedPolicy r;
+    std::copy(base.begin(), base.end(), r.base.begin());
+    std::copy(rw.begin(), rw.end(), r.rw.begin());
+    return r;
+  }
+
+  size_t footprint() const {
+    size_t n = sizeof(*this);
+    for (const auto& s: base) {
+      n += s.capacity();
+    }
+    for (const auto& s: rw) {
+      n += s.capacity();
+    }
+    return n;
+  }
+
+private:
+  friend class ResolvedPolicyCache;
+
+  std::array<std::string, 6> base;
+  std::array<std::string, 4> rw;
+  // the global generation this was last known to be valid at
+  mutable std::atomic<uint64_t> validated {0};
+  // (bucket, generation) of every key the values depend on
+  SmallVector<std::pair<uint32_t, uint64_t>, 22> deps;
+};
+
+//----------------------------------------------------------------------------
+//! Cache of resolved policies per identity on top of a VersionedPolicyStore.
+//! A hit is valid if the store's global generation did not move since the
+//! entry was last validated, which is a single load. Otherwise the
+//! generations of the keys the entry depends on are compared, so that only
+//! entries depending on changed keys are recomputed; bucket collisions can
+//! cause extra recomputations but never stale values.
+//----------------------------------------------------------------------------
+class ResolvedPolicyCache {
+public:
+  using value_type = std::shared_ptr<const CachedPolicy>;
+
+  struct Stats {
+    ShardedLruCache<CachedPolicy>::Stats cache;
+    uint64_t revalidated {0};
+    uint64_t invalidated {0};
+  };
+
+  ResolvedPolicyCache(const VersionedPolicyStore& store, size_t memory_budget,
+                      size_t nshards = 16) :
+    store(store), cache(memory_budget, nshards) {}
+
+  value_type get(std::string_view user_key, std::string_view group_key,
+                 std::string_view app_key, bool is_rw, bool local = false) {
+    SmallVector<char, 256> key;
+    MakeIdentityKey(key, user_key, group_key, app_key, is_rw, local);
+    std::string_view k(key.data(), key.size());
+    const auto& gens = store.generations();
+    if (auto v = cache.find(k)) {
+      auto g = gens.global();
+      if (v->validated.load(std::memory_order_relaxed) == g) {
+        return v;
+      }
+
+      if (is_current(*v)) {
+        v->validated.store(g, std::memory_order_relaxed);
+        revalidated.fetch_add(1, std::memory_order_relaxed);
+        return v;
+      }
+
+      cache.erase(k);
+      invalidated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return cache.get_or_create(k, [&](std::string_view) {
+      return resolve(user_key, group_key, app_key, is_rw, local);
+    });
+  }
+
+  void clear() {
+    cache.clear();
+  }
+
+  Stats stats() const {
+    return {cache.stats(), revalidated.load(std::memory_order_relaxed),
+            invalidated.load(std::memory_order_relaxed)};
+  }
+
+private:
+  bool is_current(const CachedPolicy& p) const {
+    const auto& gens = store.generations();
+    for (const auto& [bucket, gen]: p.deps) {
+      if (gens.bucket(bucket) != gen) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::shared_ptr<CachedPolicy> resolve(std::string_view user_key,
+                                        std::string_view group_key,
+                                        std::string_view app_key,
+                                        bool is_rw, bool local) const {
+    using Suffix = PolicyKeyTemplate::Suffix;
+    const auto& gens = store.generations();
+    auto p = std::make_shared<CachedPolicy>();
+    // generations are read before the store, a change made in between
+    // leaves the entry looking stale rather than the other way round
+    p->validated.store(gens.global(), std::memory_order_relaxed);
+    for (const auto& part: detail::PolicyTemplateFor(is_rw, local).get_parts()) {
+      std::string_view suffix;
+      switch (part.suffix) {
+      case Suffix::App: suffix = app_key; break;
+      case Suffix::User: suffix = user_key; break;
+      case Suffix::Group: suffix = group_key; break;
+      case Suffix::None: break;
+      }
+      auto bucket = PolicyGenerations::bucket_of(part.prefix, suffix);
+      p->deps.emplace_back(bucket, gens.bucket(bucket));
+    }
+
+    store.read([&](const FlatPolicyMap& m) {
+      auto r = ResolvePolicy(m, user_key, group_key, app_key, is_rw, local);
+      std::copy(r.base.begin(), r.base.end(), p->base.begin());
+      std::copy(r.rw.begin(), r.rw.end(), p->rw.begin());
+    });
+    return p;
+  }
+
+  const VersionedPolicyStore& store;
+  ShardedLruCache<CachedPolicy> cache;
+  std::atomic<uint64_t> revalidated {0};
+  std::atomic<uint64_t> invalidated {0};
+};
+
+} // namespace eos::common
@@ -0,0 +1,99 @@
+// ----------------------------------------------------------------------
+// File: zipf.hpp
+// Author: Abhishek Lekshmanan - CERN
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2021 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+//----------------------------------------------------------------------------
+//! Zipf distributed integers in [0, n), rank 0 being the most popular, for
+//! modelling skewed access in benchmarks. Uses rejection-inversion sampling
+//! (Hörmann & Derflinger) so it needs O(1) memory regardless of n and can be
+//! used like any of the std <random> distributions.
+//----------------------------------------------------------------------------
+class ZipfDistribution {
+public:
+  explicit ZipfDistribution(uint64_t n, double exponent = 0.99) :
+    n(n), exponent(exponent),
+    h_x1(h_integral(1.5) - 1.0),
+    h_n(h_integral(n + 0.5)),
+    s(2.0 - h_integral_inverse(h_integral(2.5) - h(2.0))) {}
+
+  template <typename URNG>
+  uint64_t operator()(URNG& gen) {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    while (true) {
+      double u = h_n + uniform(gen) * (h_x1 - h_n);
+      double x = h_integral_inverse(u);
+      double k = std::floor(x + 0.5);
+      if (k < 1) {
+        k = 1;
+      } else if (k > n) {
+        k = n;
+      }
+
+      if (k - x <= s || u >= h_integral(k + 0.5) - h(k)) {
+        return static_cast<uint64_t>(k) - 1;
+      }
+    }
+  }
+
+  uint64_t max() const { return n - 1; }
+
+private:
+  double h(double x) const {
+    return std::exp(-exponent * std::log(x));
+  }
+
+  double h_integral(double x) const {
+    double log_x = std::log(x);
+    return helper2((1.0 - exponent) * log_x) * log_x;
+  }
+
+  double h_integral_inverse(double x) const {
+    double t = x * (1.0 - exponent);
+    if (t < -1.0) {
+      t = -1.0;
+    }
+    return std::exp(helper1(t) * x);
+  }
+
+  // log1p(x)/x and expm1(x)/x, with their limits near 0
+  static double helper1(double x) {
+    return std::abs(x) > 1e-8 ? std::log1p(x) / x :
+           1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+  }
+
+  static double helper2(double x) {
+    return std::abs(x) > 1e-8 ? std::expm1(x) / x :
+           1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+  }
+
+  uint64_t n;
+  double exponent;
+  double h_x1;
+  double h_n;
+  double s;
+};